@@ -0,0 +1,152 @@
+#include <benchmark/benchmark.h>
+#include "packet_buffer_pool.hpp"
+#include "packet_buffer.hpp"
+#include "lockfree_free_list.hpp"
+#include <mutex>
+#include <vector>
+
+// Multi-threaded allocate/release throughput of a single shared PacketBufferPool.
+// Compare against BM_MutexVectorFreeList (the previous std::mutex + std::vector design)
+// at the same thread counts to see how each scales with cores.
+
+namespace {
+
+constexpr size_t kPoolSize = 64 * 1024;
+constexpr int kBurst = 8; // Buffers each thread holds at once, so frees interleave with other threads' allocs
+
+PacketBufferPool* shared_pool = nullptr;
+
+// Reference implementation of the old free list, kept here only for comparison.
+struct MutexVectorFreeList {
+    std::mutex mutex;
+    std::vector<int> items;
+    explicit MutexVectorFreeList(size_t n) {
+        items.reserve(n);
+        for (size_t i = 0; i < n; ++i) {
+            items.push_back(static_cast<int>(i));
+        }
+    }
+    int pop() {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (items.empty()) {
+            return -1;
+        }
+        int v = items.back();
+        items.pop_back();
+        return v;
+    }
+    void push(int v) {
+        std::lock_guard<std::mutex> lock(mutex);
+        items.push_back(v);
+    }
+};
+
+MutexVectorFreeList* shared_mutex_list = nullptr;
+LockFreeFreeList* shared_lockfree_list = nullptr;
+
+// Setup/Teardown run once per benchmark run, outside the worker threads.
+void create_pool(const benchmark::State&) {
+    shared_pool = new PacketBufferPool(2048, kPoolSize);
+}
+
+void create_cached_pool(const benchmark::State&) {
+    shared_pool = new PacketBufferPool(2048, kPoolSize, -1, 64, 0, 256);
+}
+
+void destroy_pool(const benchmark::State&) {
+    delete shared_pool;
+    shared_pool = nullptr;
+}
+
+void create_mutex_list(const benchmark::State&) {
+    shared_mutex_list = new MutexVectorFreeList(kPoolSize);
+}
+
+void destroy_mutex_list(const benchmark::State&) {
+    delete shared_mutex_list;
+    shared_mutex_list = nullptr;
+}
+
+void create_lockfree_list(const benchmark::State&) {
+    shared_lockfree_list = new LockFreeFreeList(kPoolSize);
+    for (uint32_t i = 0; i < kPoolSize; ++i) {
+        shared_lockfree_list->push(i);
+    }
+}
+
+void destroy_lockfree_list(const benchmark::State&) {
+    delete shared_lockfree_list;
+    shared_lockfree_list = nullptr;
+}
+
+} // namespace
+
+static void BM_PoolAllocRelease(benchmark::State& state) {
+    PacketBuffer* held[kBurst];
+    for (auto _ : state) {
+        for (int i = 0; i < kBurst; ++i) {
+            held[i] = shared_pool->allocate_buffer();
+        }
+        for (int i = 0; i < kBurst; ++i) {
+            if (held[i]) {
+                held[i]->release();
+            }
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * kBurst);
+}
+BENCHMARK(BM_PoolAllocRelease)->Setup(create_pool)->Teardown(destroy_pool)
+    ->ThreadRange(1, 64)->UseRealTime();
+// Same workload with a per-thread cache in front of the shared free list.
+BENCHMARK(BM_PoolAllocRelease)->Name("BM_PoolAllocReleaseThreadCache")
+    ->Setup(create_cached_pool)->Teardown(destroy_pool)->ThreadRange(1, 64)->UseRealTime();
+
+static void BM_MutexVectorFreeList(benchmark::State& state) {
+    int held[kBurst];
+    for (auto _ : state) {
+        for (int i = 0; i < kBurst; ++i) {
+            held[i] = shared_mutex_list->pop();
+        }
+        for (int i = 0; i < kBurst; ++i) {
+            if (held[i] >= 0) {
+                shared_mutex_list->push(held[i]);
+            }
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * kBurst);
+}
+BENCHMARK(BM_MutexVectorFreeList)->Setup(create_mutex_list)->Teardown(destroy_mutex_list)
+    ->ThreadRange(1, 64)->UseRealTime();
+
+// The free-list engine on its own, without PacketBuffer bookkeeping: the like-for-like
+// counterpart of BM_MutexVectorFreeList.
+static void BM_LockFreeFreeList(benchmark::State& state) {
+    uint32_t held[kBurst];
+    for (auto _ : state) {
+        for (int i = 0; i < kBurst; ++i) {
+            held[i] = shared_lockfree_list->pop();
+        }
+        for (int i = 0; i < kBurst; ++i) {
+            if (held[i] != LockFreeFreeList::kEmpty) {
+                shared_lockfree_list->push(held[i]);
+            }
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * kBurst);
+}
+BENCHMARK(BM_LockFreeFreeList)->Setup(create_lockfree_list)->Teardown(destroy_lockfree_list)
+    ->ThreadRange(1, 64)->UseRealTime();
+
+// Burst allocate/free as an RX loop would do it, against one call per buffer above.
+static void BM_PoolAllocFreeBulk(benchmark::State& state) {
+    const size_t burst = static_cast<size_t>(state.range(0));
+    std::vector<PacketBuffer*> held(burst);
+    for (auto _ : state) {
+        if (shared_pool->allocate_bulk(held.data(), burst)) {
+            shared_pool->free_bulk(held.data(), burst);
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * burst);
+}
+BENCHMARK(BM_PoolAllocFreeBulk)->Setup(create_pool)->Teardown(destroy_pool)
+    ->Arg(8)->Arg(32)->Arg(64)->ThreadRange(1, 16)->UseRealTime();
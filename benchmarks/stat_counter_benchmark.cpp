@@ -0,0 +1,69 @@
+#include <benchmark/benchmark.h>
+#include "sharded_counters.hpp"
+#include <atomic>
+#include <cstdint>
+
+// Per-operation cost of the pool statistics counters: the previous design (one shared
+// std::atomic per statistic, fetch_add from every thread) against ShardedCounters (one
+// cache-line shard per ThreadSlot, summed on read). Both bump two counters per op, like
+// an allocate followed by a free.
+
+namespace {
+
+struct SharedAtomicCounters {
+    alignas(64) std::atomic<uint64_t> allocs{0};
+    std::atomic<uint64_t> deallocs{0}; // Same line, as the two pool fields were
+};
+
+SharedAtomicCounters* shared_atomics = nullptr;
+ShardedCounters<2>* sharded = nullptr;
+
+void create_shared_atomics(const benchmark::State&) {
+    shared_atomics = new SharedAtomicCounters();
+}
+
+void destroy_shared_atomics(const benchmark::State&) {
+    delete shared_atomics;
+    shared_atomics = nullptr;
+}
+
+void create_sharded(const benchmark::State&) {
+    sharded = new ShardedCounters<2>();
+}
+
+void destroy_sharded(const benchmark::State&) {
+    delete sharded;
+    sharded = nullptr;
+}
+
+} // namespace
+
+static void BM_SharedAtomicCounters(benchmark::State& state) {
+    for (auto _ : state) {
+        shared_atomics->allocs.fetch_add(1, std::memory_order_relaxed);
+        shared_atomics->deallocs.fetch_add(1, std::memory_order_relaxed);
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_SharedAtomicCounters)->Setup(create_shared_atomics)->Teardown(destroy_shared_atomics)
+    ->ThreadRange(1, 64)->UseRealTime();
+
+static void BM_ShardedCounters(benchmark::State& state) {
+    for (auto _ : state) {
+        sharded->add(0);
+        sharded->add(1);
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_ShardedCounters)->Setup(create_sharded)->Teardown(destroy_sharded)
+    ->ThreadRange(1, 64)->UseRealTime();
+
+// Reader side: what a monitoring poll pays per statistic.
+static void BM_ShardedCountersSum(benchmark::State& state) {
+    ShardedCounters<2> counters;
+    counters.add(0);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(counters.sum(0));
+    }
+}
+BENCHMARK(BM_ShardedCountersSum);
@@ -0,0 +1,37 @@
+#ifndef BUFFER_HANDLE_HPP
+#define BUFFER_HANDLE_HPP
+
+#include <cstdint> // For uint32_t
+
+// Compact 32-bit name for a pooled PacketBuffer: [pool id:8 | index:24]. Half the size of a
+// pointer, so queues and flow tables holding millions of buffers take half the memory and
+// twice as many entries fit in a cache line. The pool id is a process-wide registration
+// slot handed out by PacketBufferPool (see PacketBufferPool::resolve()); the index is the
+// buffer's slot in that pool's buffer table.
+//
+// A default-constructed handle is invalid. Handles stay resolvable for as long as the
+// pool that issued them lives; a handle outliving its pool may resolve to a buffer of a
+// later pool that reused the id, exactly as a dangling pointer would.
+struct BufferHandle {
+    static constexpr uint32_t kIndexBits = 24;
+    static constexpr uint32_t kMaxIndex = (1u << kIndexBits) - 1;
+    static constexpr uint32_t kMaxPools = (1u << (32 - kIndexBits)) - 1; // Id 255 is kept for kInvalid
+    static constexpr uint32_t kInvalid = 0xFFFFFFFFu;
+
+    uint32_t value = kInvalid;
+
+    static constexpr BufferHandle make(uint32_t pool_id, uint32_t index) {
+        return BufferHandle{(pool_id << kIndexBits) | index};
+    }
+
+    constexpr uint32_t pool_id() const { return value >> kIndexBits; }
+    constexpr uint32_t index() const { return value & kMaxIndex; }
+    constexpr bool valid() const { return value != kInvalid; }
+
+    constexpr bool operator==(BufferHandle other) const { return value == other.value; }
+    constexpr bool operator!=(BufferHandle other) const { return value != other.value; }
+};
+
+static_assert(sizeof(BufferHandle) == sizeof(uint32_t), "BufferHandle must stay 32 bits");
+
+#endif // BUFFER_HANDLE_HPP
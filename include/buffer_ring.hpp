@@ -0,0 +1,161 @@
+#ifndef BUFFER_RING_HPP
+#define BUFFER_RING_HPP
+
+#include <atomic>
+#include <cstddef>   // For size_t
+#include <cstdint>   // For uint32_t
+#include <memory>    // For std::unique_ptr
+#include <stdexcept> // For std::invalid_argument
+#include <thread>    // For std::this_thread::yield
+#include "buffer_handle.hpp"
+
+class PacketBuffer;
+
+// Concurrency modes of one side (producers or consumers) of a BufferRing.
+enum class RingSync {
+    Single, // Exactly one thread uses this side: plain stores, no CAS
+    Multi,  // Any number of threads: slots are claimed with a CAS on the head
+};
+
+// Bounded FIFO of PacketBuffer* (or, with T = BufferHandle, of 32-bit handles at half the
+// slot footprint) for handing bursts of buffers between pipeline stages (RX -> worker ->
+// TX). Ownership of each buffer moves with it; the ring never touches reference counts.
+//
+// Each side keeps a head (slots claimed) and a tail (slots published) as free-running
+// 32-bit counters; the capacity is a power of two so a counter maps to a slot with a mask
+// and the counters may wrap. A burst costs one claim and one publish per side, however
+// many buffers it carries: a multi-producer claims its range with one CAS on prod_.head,
+// copies its pointers in, then waits for earlier claimants to publish before advancing
+// prod_.tail past its own range (release), which is what makes the pointers visible to
+// consumers (acquire on the same word). Consumers mirror this on cons_.
+//
+// The producer and consumer words sit on separate cache lines, and the slot array on its
+// own allocation, so the two sides only share lines through the slots they hand over.
+template <RingSync Producers, RingSync Consumers, typename T = PacketBuffer*>
+class BufferRing {
+public:
+    explicit BufferRing(uint32_t capacity)
+        : capacity_(checked_capacity(capacity)),
+          mask_(capacity - 1),
+          slots_(new T[capacity]) {}
+
+    BufferRing(const BufferRing&) = delete;
+    BufferRing& operator=(const BufferRing&) = delete;
+
+    // Enqueues up to n buffers from bufs, in order, and returns how many went in.
+    size_t enqueue_burst(const T* bufs, size_t n) { return enqueue(bufs, n, false); }
+    // All-or-nothing: enqueues all n buffers, or none if there is not room for all of them.
+    bool enqueue_bulk(const T* bufs, size_t n) { return enqueue(bufs, n, true) == n; }
+    bool enqueue(T buf) { return enqueue(&buf, 1, true) == 1; }
+
+    // Dequeues up to n buffers into out, oldest first, and returns how many came out.
+    size_t dequeue_burst(T* out, size_t n) { return dequeue(out, n, false); }
+    // All-or-nothing counterpart of dequeue_burst.
+    bool dequeue_bulk(T* out, size_t n) { return dequeue(out, n, true) == n; }
+    // The oldest entry, or T() (nullptr / an invalid handle) if the ring is empty.
+    T dequeue() {
+        T item = T();
+        dequeue(&item, 1, true);
+        return item;
+    }
+
+    uint32_t capacity() const { return capacity_; }
+    // Momentary occupancy; exact only while neither side is mid-operation.
+    size_t size() const {
+        return prod_.tail.load(std::memory_order_acquire) - cons_.tail.load(std::memory_order_acquire);
+    }
+    bool empty() const { return size() == 0; }
+
+private:
+    struct alignas(64) HeadTail {
+        std::atomic<uint32_t> head{0}; // Next counter this side will claim
+        std::atomic<uint32_t> tail{0}; // Everything before this is published to the other side
+    };
+
+    static uint32_t checked_capacity(uint32_t capacity) {
+        if (capacity == 0 || (capacity & (capacity - 1)) != 0 || capacity > (1u << 31)) {
+            throw std::invalid_argument("BufferRing: capacity must be a power of two no larger than 2^31");
+        }
+        return capacity;
+    }
+
+    size_t enqueue(const T* bufs, size_t n, bool all_or_nothing) {
+        uint32_t old_head = prod_.head.load(std::memory_order_relaxed);
+        uint32_t count;
+        for (;;) {
+            // Acquire pairs with the consumers' tail release: their reads of these slots are done.
+            const uint32_t free_slots = capacity_ - (old_head - cons_.tail.load(std::memory_order_acquire));
+            count = n < free_slots ? static_cast<uint32_t>(n) : free_slots;
+            if (count == 0 || (all_or_nothing && count != n)) {
+                return 0;
+            }
+            if (Producers == RingSync::Single) {
+                prod_.head.store(old_head + count, std::memory_order_relaxed);
+                break;
+            }
+            if (prod_.head.compare_exchange_weak(old_head, old_head + count,
+                                                 std::memory_order_relaxed,
+                                                 std::memory_order_relaxed)) {
+                break;
+            }
+        }
+        for (uint32_t i = 0; i < count; ++i) {
+            slots_[(old_head + i) & mask_] = bufs[i];
+        }
+        publish(prod_, old_head, old_head + count);
+        return count;
+    }
+
+    size_t dequeue(T* out, size_t n, bool all_or_nothing) {
+        uint32_t old_head = cons_.head.load(std::memory_order_relaxed);
+        uint32_t count;
+        for (;;) {
+            // Acquire pairs with the producers' tail release: the slot writes are visible.
+            const uint32_t ready = prod_.tail.load(std::memory_order_acquire) - old_head;
+            count = n < ready ? static_cast<uint32_t>(n) : ready;
+            if (count == 0 || (all_or_nothing && count != n)) {
+                return 0;
+            }
+            if (Consumers == RingSync::Single) {
+                cons_.head.store(old_head + count, std::memory_order_relaxed);
+                break;
+            }
+            if (cons_.head.compare_exchange_weak(old_head, old_head + count,
+                                                 std::memory_order_relaxed,
+                                                 std::memory_order_relaxed)) {
+                break;
+            }
+        }
+        for (uint32_t i = 0; i < count; ++i) {
+            out[i] = slots_[(old_head + i) & mask_];
+        }
+        publish(cons_, old_head, old_head + count);
+        return count;
+    }
+
+    // Advances side.tail over [from, to) once every earlier claim on that side has been
+    // published, so the other side never sees a slot that is still being filled or read.
+    // The acquire chains the earlier claimants' slot accesses into this release.
+    static void publish(HeadTail& side, uint32_t from, uint32_t to) {
+        while (side.tail.load(std::memory_order_acquire) != from) {
+            std::this_thread::yield(); // Only reachable with multiple threads on this side
+        }
+        side.tail.store(to, std::memory_order_release);
+    }
+
+    HeadTail prod_;
+    HeadTail cons_;
+    alignas(64) const uint32_t capacity_;
+    const uint32_t mask_;
+    std::unique_ptr<T[]> slots_;
+};
+
+using SpscBufferRing = BufferRing<RingSync::Single, RingSync::Single>;
+using MpscBufferRing = BufferRing<RingSync::Multi, RingSync::Single>;
+using MpmcBufferRing = BufferRing<RingSync::Multi, RingSync::Multi>;
+
+using SpscHandleRing = BufferRing<RingSync::Single, RingSync::Single, BufferHandle>;
+using MpscHandleRing = BufferRing<RingSync::Multi, RingSync::Single, BufferHandle>;
+using MpmcHandleRing = BufferRing<RingSync::Multi, RingSync::Multi, BufferHandle>;
+
+#endif // BUFFER_RING_HPP
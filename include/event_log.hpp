@@ -0,0 +1,106 @@
+#ifndef EVENT_LOG_HPP
+#define EVENT_LOG_HPP
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef> // For size_t
+#include <cstdint> // For uintXX_t types
+#include <functional>
+#include <memory>  // For std::unique_ptr
+#include <mutex>
+#include <string>
+#include <thread>
+
+// Binary record of something noteworthy on an allocation path.
+struct EventRecord {
+    enum class Type : uint8_t {
+        PoolExhausted,   // A pool was found but had no free buffer (or not enough for a burst)
+        NoSuitablePool,  // No pool on the node (or global) can hold the requested size
+        LocalExhausted,  // kCurrentNode allocation failed on the local node and every fallback
+        kCount
+    };
+
+    uint64_t timestamp_ns = 0; // steady_clock
+    Type type = Type::PoolExhausted;
+    int32_t numa_node = -1;    // As requested (or the resolved local node)
+    uint64_t payload_size = 0; // Requested payload size
+    uint64_t count = 1;        // Buffers requested (burst size for bulk calls)
+};
+
+const char* event_type_name(EventRecord::Type type);
+std::string format_event(const EventRecord& record);
+
+// Lock-free, rate-limited event log for data-plane code paths.
+//
+// record() never blocks, takes no lock and does no I/O: it claims a slot in a bounded
+// multi-producer ring of EventRecords (Vyukov-style per-slot sequence numbers) and returns.
+// Each event type is limited to max_per_window records per window; the excess is only
+// counted (suppressed_count()), as are records that found the ring full (dropped_count()).
+// Records leave the ring through drain(), called on demand or by the optional background
+// drain thread, which hands them to a sink outside the data path.
+class EventLog {
+public:
+    using Sink = std::function<void(const EventRecord&)>;
+
+    explicit EventLog(size_t capacity = 1024,
+                      uint32_t max_per_window = 16,
+                      std::chrono::milliseconds window = std::chrono::milliseconds(1000));
+    ~EventLog();
+
+    EventLog(const EventLog&) = delete;
+    EventLog& operator=(const EventLog&) = delete;
+
+    void record(EventRecord::Type type, int numa_node, size_t payload_size, size_t count = 1);
+
+    // Pops every queued record into sink, oldest first, and returns how many. Safe to call
+    // concurrently with record() and with other drain() calls.
+    size_t drain(const Sink& sink);
+
+    // Starts a thread that drains into sink every interval (and on stop). The default sink
+    // writes format_event() lines to std::cerr. Restarting replaces the previous thread.
+    void start_background_drain(Sink sink = Sink(),
+                                std::chrono::milliseconds interval = std::chrono::milliseconds(100));
+    void stop_background_drain();
+
+    uint64_t recorded_count() const { return recorded_.load(std::memory_order_relaxed); }
+    uint64_t suppressed_count() const;
+    uint64_t suppressed_count(EventRecord::Type type) const;
+    uint64_t dropped_count() const { return dropped_.load(std::memory_order_relaxed); }
+
+private:
+    struct alignas(64) Cell {
+        std::atomic<size_t> sequence{0};
+        EventRecord record;
+    };
+
+    // Fixed-window limiter state, one per event type.
+    struct alignas(64) RateLimit {
+        std::atomic<uint64_t> window_start_ns{0};
+        std::atomic<uint32_t> in_window{0};
+        std::atomic<uint64_t> suppressed{0};
+    };
+
+    bool admit(RateLimit& limit, uint64_t now_ns);
+    bool try_pop(EventRecord& out);
+
+    const size_t capacity_; // Power of two
+    const size_t mask_;
+    const uint32_t max_per_window_;
+    const uint64_t window_ns_;
+    std::unique_ptr<Cell[]> cells_;
+
+    alignas(64) std::atomic<size_t> enqueue_pos_{0};
+    alignas(64) std::atomic<size_t> dequeue_pos_{0};
+    alignas(64) std::atomic<uint64_t> recorded_{0};
+    std::atomic<uint64_t> dropped_{0};
+    RateLimit limits_[static_cast<size_t>(EventRecord::Type::kCount)];
+
+    // Background drain thread
+    std::mutex drain_mutex_;
+    std::condition_variable drain_cv_;
+    bool drain_stop_ = false;
+    std::thread drain_thread_;
+};
+
+#endif // EVENT_LOG_HPP
@@ -0,0 +1,132 @@
+#ifndef LOCKFREE_FREE_LIST_HPP
+#define LOCKFREE_FREE_LIST_HPP
+
+#include <atomic>
+#include <cstddef> // For size_t
+#include <cstdint> // For uintXX_t types
+#include <memory>  // For std::unique_ptr
+
+// Lock-free LIFO of buffer indices, used by PacketBufferPool as its free list.
+//
+// Entries are 32-bit indices into the pool's buffer table rather than pointers, and the
+// links live in a side array owned by the list, so a node is never dereferenced after it
+// has been handed out. The head word packs [tag:32 | index:32]; the tag is bumped on every
+// successful CAS, which defeats ABA (a pop that observed head A -> B cannot succeed after
+// another thread popped A, popped B and pushed A back, because the tag no longer matches).
+//
+// The hot members are defined inline here: push/pop sit directly on the allocation path.
+class LockFreeFreeList {
+public:
+    static constexpr uint32_t kEmpty = 0xFFFFFFFFu; // "No index" sentinel
+
+    explicit LockFreeFreeList(uint32_t capacity)
+        : capacity_(capacity),
+          next_(new std::atomic<uint32_t>[capacity]) {
+        for (uint32_t i = 0; i < capacity; ++i) {
+            next_[i].store(kEmpty, std::memory_order_relaxed);
+        }
+    }
+
+    LockFreeFreeList(const LockFreeFreeList&) = delete;
+    LockFreeFreeList& operator=(const LockFreeFreeList&) = delete;
+
+    // Pushes a single index. Release ordering publishes every write the caller made to the
+    // buffer before freeing it to whichever thread pops it next.
+    void push(uint32_t index) {
+        uint64_t old_head = head_.load(std::memory_order_relaxed);
+        uint64_t new_head;
+        do {
+            next_[index].store(index_of(old_head), std::memory_order_relaxed);
+            new_head = pack(tag_of(old_head) + 1, index);
+        } while (!head_.compare_exchange_weak(old_head, new_head,
+                                              std::memory_order_release,
+                                              std::memory_order_relaxed));
+    }
+
+    // Pops one index, or returns kEmpty if the list is empty.
+    uint32_t pop() {
+        uint64_t old_head = head_.load(std::memory_order_acquire);
+        for (;;) {
+            uint32_t index = index_of(old_head);
+            if (index == kEmpty) {
+                return kEmpty;
+            }
+            // next_[index] may be rewritten concurrently if another thread wins the race for
+            // this node; the tag check in the CAS then rejects our stale value.
+            uint32_t next = next_[index].load(std::memory_order_relaxed);
+            uint64_t new_head = pack(tag_of(old_head) + 1, next);
+            if (head_.compare_exchange_weak(old_head, new_head,
+                                            std::memory_order_acquire,
+                                            std::memory_order_acquire)) {
+                return index;
+            }
+        }
+    }
+
+    // Pushes count indices with a single CAS; indices[0] ends up on top.
+    void push_bulk(const uint32_t* indices, size_t count) {
+        if (count == 0) {
+            return;
+        }
+        for (size_t i = 0; i + 1 < count; ++i) {
+            next_[indices[i]].store(indices[i + 1], std::memory_order_relaxed);
+        }
+        const uint32_t first = indices[0];
+        const uint32_t last = indices[count - 1];
+        uint64_t old_head = head_.load(std::memory_order_relaxed);
+        uint64_t new_head;
+        do {
+            next_[last].store(index_of(old_head), std::memory_order_relaxed);
+            new_head = pack(tag_of(old_head) + 1, first);
+        } while (!head_.compare_exchange_weak(old_head, new_head,
+                                              std::memory_order_release,
+                                              std::memory_order_relaxed));
+    }
+
+    // Pops up to max_count indices with a single CAS and returns how many were taken.
+    // The walk below the head is only trusted if the CAS proves the head (and so, since
+    // nodes only leave from the top, the whole chain) was untouched while we read it.
+    size_t pop_bulk(uint32_t* out, size_t max_count) {
+        if (max_count == 0) {
+            return 0;
+        }
+        uint64_t old_head = head_.load(std::memory_order_acquire);
+        for (;;) {
+            size_t taken = 0;
+            uint32_t cursor = index_of(old_head);
+            while (taken < max_count && cursor != kEmpty) {
+                out[taken++] = cursor;
+                cursor = next_[cursor].load(std::memory_order_relaxed);
+            }
+            if (taken == 0) {
+                return 0;
+            }
+            uint64_t new_head = pack(tag_of(old_head) + 1, cursor);
+            if (head_.compare_exchange_weak(old_head, new_head,
+                                            std::memory_order_acquire,
+                                            std::memory_order_acquire)) {
+                return taken;
+            }
+        }
+    }
+
+    bool empty() const {
+        return index_of(head_.load(std::memory_order_relaxed)) == kEmpty;
+    }
+
+    uint32_t capacity() const { return capacity_; }
+
+private:
+    static uint64_t pack(uint32_t tag, uint32_t index) {
+        return (static_cast<uint64_t>(tag) << 32) | index;
+    }
+    static uint32_t tag_of(uint64_t head) { return static_cast<uint32_t>(head >> 32); }
+    static uint32_t index_of(uint64_t head) { return static_cast<uint32_t>(head); }
+
+    // The head gets its own cache line: it is the only word every core writes.
+    alignas(64) std::atomic<uint64_t> head_{pack(0, kEmpty)};
+    alignas(64) uint32_t capacity_;
+    std::unique_ptr<std::atomic<uint32_t>[]> next_; // next_[i]: index below i in the stack
+};
+
+#endif // LOCKFREE_FREE_LIST_HPP
@@ -0,0 +1,44 @@
+#ifndef NUMA_TOPOLOGY_HPP
+#define NUMA_TOPOLOGY_HPP
+
+#include <cstdint> // For uint32_t
+#include <vector>
+
+// Read-only view of the host's NUMA layout, taken from /sys/devices/system/node, plus a
+// cheap "which node am I on" for the calling thread. Works without libnuma; on machines
+// without NUMA sysfs it reports a single node 0.
+class NumaTopology {
+public:
+    // Online nodes, ascending.
+    static const std::vector<int>& online_nodes();
+
+    // True if node appears in online_nodes().
+    static bool is_online(int node);
+
+    // Every online node ordered by SLIT distance from `node` (nearest first, so `node`
+    // itself leads); ties keep ascending node order. Empty for an unknown node.
+    static std::vector<int> nodes_by_distance(int node);
+
+    // NUMA node of the CPU the calling thread is running on, via getcpu(). The answer is
+    // cached per thread and refreshed every kRefreshInterval calls, so a migrated thread
+    // is picked up within a bounded number of allocations without a syscall per call.
+    static int current_node() {
+        if (calls_until_refresh_ == 0) {
+            refresh_current_node();
+        }
+        --calls_until_refresh_;
+        return cached_node_;
+    }
+
+    static constexpr uint32_t kRefreshInterval = 1024;
+
+private:
+    static void refresh_current_node();
+
+    // Inline with constant initializers, so current_node() inlines into other translation
+    // units and reads them directly rather than through a TLS wrapper call.
+    static inline thread_local int cached_node_ = 0;
+    static inline thread_local uint32_t calls_until_refresh_ = 0;
+};
+
+#endif // NUMA_TOPOLOGY_HPP
@@ -3,11 +3,17 @@
 
 #include <atomic>
 #include <cstddef> // For size_t
+#include <cstdint> // For uint32_t
 
 // Forward declarations
 class BufferMetadata;
 class PacketBufferPool;
 
+// The accessors, headroom/tailroom operations and the add_ref()/release() fast path are
+// defined inline below the class: packet-parsing code calls them once or more per header,
+// and as out-of-line calls they could not be folded into the caller without LTO. Only
+// construction, clone(), release_chain() and the last-reference return to the pool live in
+// packet_buffer.cpp.
 class PacketBuffer {
 public:
     // Constructor
@@ -18,14 +24,22 @@ public:
 
     // Reference counting
     PacketBuffer* add_ref();
+    // Drops one reference and returns the buffer to its pool with the last one. A sole
+    // owner (count 1) pays a load and a plain store instead of an atomic read-modify-write.
+    // Affects this segment only; a chained packet is freed with release_chain().
     void release();
+    // release() for a caller that knows it holds the only reference (ref_count() == 1):
+    // skips even the load. Calling it on a shared buffer is a use-after-free for the other
+    // owners.
+    void release_unshared();
     int ref_count() const;
 
     // Data access
     unsigned char* data() const; // Returns pointer to the start of packet data (after headroom)
     size_t capacity() const;    // Total buffer capacity (excluding metadata, but including headroom/tailroom)
     size_t data_len() const;    // Current length of packet data
-    void set_data_len(size_t len);
+    void set_data_len(size_t len); // Clamped to the end of the payload area (tailroom excluded)
+    void reset_data_ptr();         // Moves data() back to just after the configured headroom; data_len() is unchanged
 
     // Headroom & Tailroom
     size_t headroom_size() const;
@@ -33,9 +47,54 @@ public:
     unsigned char* reserve_headroom(size_t len); // Returns pointer to new start of data
     unsigned char* reserve_tailroom(size_t len); // Returns pointer to start of tailroom reservation
 
-    // Chaining (basic for now)
+    // Zero-copy clone. Takes a buffer from pool (typically one with a small or zero-byte
+    // data area) and makes it an indirect view of this segment's current data: the same
+    // bytes without a copy, plus its own copy of the metadata. Only this segment is
+    // cloned, not the chain behind it. The clone holds one reference on the buffer that
+    // owns the bytes (the original, or the original's original when cloning a clone)
+    // until it is itself released. As the bytes are shared, a clone has no headroom or
+    // tailroom of its own: per-egress headers go into a small buffer chained in front of
+    // it. Returns nullptr if pool is exhausted.
+    PacketBuffer* clone(PacketBufferPool& pool);
+    bool is_clone() const;
+    PacketBuffer* direct_buffer() const; // Owner of a clone's bytes; nullptr for a direct buffer
+
+    // Multi-segment packets. A packet larger than one buffer is a chain of segments linked
+    // through next_buffer(), its head standing for the whole packet, so jumbo frames can be
+    // built from ordinary 2K buffers. The totals are walked rather than cached in the head,
+    // so they stay right whichever segment's length changes.
+    class SegmentIterator {
+    public:
+        explicit SegmentIterator(PacketBuffer* segment) : segment_(segment) {}
+        PacketBuffer* operator*() const { return segment_; }
+        SegmentIterator& operator++() {
+            segment_ = segment_->next_;
+            return *this;
+        }
+        bool operator==(const SegmentIterator& other) const { return segment_ == other.segment_; }
+        bool operator!=(const SegmentIterator& other) const { return segment_ != other.segment_; }
+
+    private:
+        PacketBuffer* segment_;
+    };
+    struct SegmentRange {
+        PacketBuffer* head;
+        SegmentIterator begin() const { return SegmentIterator(head); }
+        SegmentIterator end() const { return SegmentIterator(nullptr); }
+    };
+
     PacketBuffer* next_buffer() const;
-    void set_next_buffer(PacketBuffer* next);
+    void set_next_buffer(PacketBuffer* next);   // Links exactly one successor, replacing any tail
+    void append_segment(PacketBuffer* tail);    // Links tail (and its own chain) after the last segment
+    PacketBuffer* last_segment();
+    SegmentRange segments();                    // for (PacketBuffer* seg : pkt->segments())
+    size_t pkt_len() const;                     // Sum of data_len() over the chain
+    size_t nb_segs() const;
+    // Drops one reference from every segment, like calling release() on each, returning
+    // those that reach zero through one PacketBufferPool::free_bulk() call per 64
+    // segments (segments of other pools go home individually). Sharing a chained packet
+    // therefore means an add_ref() on each of its segments.
+    void release_chain();
 
     // Metadata
     BufferMetadata* metadata(); // Implementation will be in .cpp
@@ -43,26 +102,189 @@ public:
     // NUMA node
     int get_numa_node() const;
 
-private:
-    unsigned char* buffer_start_ = nullptr;       // Start of the data region [headroom|payload|tailroom]
-    size_t total_allocated_size_ = 0;       // Total size of the data region [headroom|payload|tailroom]
+    // Pool this buffer returns to on its last release()
+    PacketBufferPool* get_owning_pool() const;
 
-    unsigned char* data_ptr_ = nullptr;           // Pointer to where current packet data starts (within the payload part)
-    size_t data_len_ = 0;                    // Current length of the packet data
+private:
+    // Puts data pointers/length/chaining back to their pristine state before the buffer
+    // returns to its pool. Shared by release() and PacketBufferPool::free_bulk().
+    void reset_for_reuse();
+    void return_to_pool(); // release() after the last reference is gone
 
-    size_t headroom_ = 0;                     // Initial configured headroom size
-    size_t tailroom_ = 0;                     // Initial configured tailroom size
+    // Field order is the cache-line layout (guarded by tests/packet_buffer_layout_test.cpp).
+    // Pools place each PacketBuffer at the start of its 64-byte aligned unit, so the first
+    // 64 bytes are exactly one cache line holding everything parsing, prepend/append,
+    // reference counting and the return to the pool touch. The one exception is direct_,
+    // which the return reads from the second line; it dirties that line anyway through
+    // the BufferMetadata placed after this object. Sizes and offsets are 32-bit (the pool
+    // rejects data areas of 4 GiB or more).
 
+    // Line 0: hot
+    unsigned char* data_ptr_ = nullptr;        // Where current packet data starts (within the payload part)
+    uint32_t data_len_ = 0;                    // Current length of the packet data
+    std::atomic<int> ref_count_{0};            // 0 after construction; the pool sets 1 on allocation
+    PacketBuffer* next_ = nullptr;             // For buffer chaining
+    unsigned char* buffer_start_ = nullptr;    // Start of the data region [headroom|payload|tailroom]
+    uint32_t total_allocated_size_ = 0;        // Total size of the data region [headroom|payload|tailroom]
+    uint32_t headroom_ = 0;                    // Initial configured headroom size
+    uint32_t tailroom_ = 0;                    // Initial configured tailroom size
+    uint32_t pool_index_ = 0;                  // Slot of this buffer in owning_pool_'s buffer table (set by the pool)
+    PacketBufferPool* owning_pool_ = nullptr;  // Pool this buffer returns to
+    BufferMetadata* metadata_ = nullptr;       // Pointer to associated metadata
 
-    std::atomic<int> ref_count_{0};          // Atomic reference counter, initialized to 0 by constructor (pool sets to 1 on alloc)
-    PacketBuffer* next_ = nullptr;               // For buffer chaining
-    BufferMetadata* metadata_ = nullptr;         // Pointer to associated metadata
+    // Line 1: cold
     int numa_node_ = -1;                       // NUMA node affinity
-    PacketBufferPool* owning_pool_ = nullptr;    // Pointer to the pool that owns this buffer
+    PacketBuffer* direct_ = nullptr;           // Set on a clone: the buffer whose bytes it views (one reference held)
 
     // Friend class for pool to access private members if necessary for allocation/deallocation
     // (though with owning_pool_ and public methods, this might be less needed)
     friend class PacketBufferPool;
 };
 
+inline PacketBuffer* PacketBuffer::add_ref() {
+    ref_count_.fetch_add(1, std::memory_order_relaxed);
+    return this;
+}
+
+inline void PacketBuffer::release() {
+    // With a count of 1 the caller holds the only reference, so no other thread can be
+    // changing it: skip the RMW (return_to_pool() zeroes the count). The acquire pairs with
+    // the release half of the fetch_sub by which any previous co-owner let go, so their
+    // writes to the buffer are visible before it is recycled. Otherwise fetch_sub returns
+    // the value before the subtraction: 1 means this was the last reference.
+    if (ref_count_.load(std::memory_order_acquire) == 1 ||
+        ref_count_.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+        return_to_pool();
+    }
+}
+
+inline void PacketBuffer::release_unshared() {
+    return_to_pool();
+}
+
+inline int PacketBuffer::ref_count() const {
+    return ref_count_.load(std::memory_order_relaxed);
+}
+
+inline unsigned char* PacketBuffer::data() const {
+    return data_ptr_;
+}
+
+// The payload capacity: the [headroom|payload|tailroom] region minus the configured
+// headroom and tailroom.
+inline size_t PacketBuffer::capacity() const {
+    return total_allocated_size_ - headroom_ - tailroom_;
+}
+
+inline size_t PacketBuffer::data_len() const {
+    return data_len_;
+}
+
+inline void PacketBuffer::set_data_len(size_t len) {
+    // Space from data_ptr_ onwards ends at the payload end; the configured tailroom is only
+    // handed out explicitly through reserve_tailroom(). Too long a length is truncated.
+    unsigned char* payload_end = buffer_start_ + total_allocated_size_ - tailroom_;
+    size_t max_len = (payload_end > data_ptr_) ? static_cast<size_t>(payload_end - data_ptr_) : 0;
+    data_len_ = static_cast<uint32_t>(len > max_len ? max_len : len);
+}
+
+inline void PacketBuffer::reset_data_ptr() {
+    data_ptr_ = buffer_start_ + headroom_;
+}
+
+// Returns the initial configured headroom size.
+inline size_t PacketBuffer::headroom_size() const {
+    return headroom_;
+}
+
+// Returns the initial configured tailroom size.
+inline size_t PacketBuffer::tailroom_size() const {
+    return tailroom_;
+}
+
+// Makes more of the pre-allocated headroom usable by moving data_ptr_ back.
+// Increases data_len_ by the same amount as the data is now considered "prepended".
+inline unsigned char* PacketBuffer::reserve_headroom(size_t len) {
+    size_t current_dynamic_headroom = static_cast<size_t>(data_ptr_ - buffer_start_);
+    if (len > current_dynamic_headroom) {
+        return nullptr; // Not enough dynamic headroom available to reserve
+    }
+    data_ptr_ -= len;
+    data_len_ += static_cast<uint32_t>(len); // The newly "reserved" space is now part of the data
+    return data_ptr_;
+}
+
+// Consumes 'len' bytes from the end of the data region (payload slack, then tailroom),
+// making them part of the data; returns where the caller should write them. The
+// configured tailroom_ itself never changes.
+inline unsigned char* PacketBuffer::reserve_tailroom(size_t len) {
+    size_t current_dynamic_tailroom = static_cast<size_t>((buffer_start_ + total_allocated_size_) - (data_ptr_ + data_len_));
+    if (len > current_dynamic_tailroom) {
+        return nullptr; // Not enough dynamic tailroom available
+    }
+    unsigned char* write_ptr = data_ptr_ + data_len_;
+    data_len_ += static_cast<uint32_t>(len);
+    return write_ptr;
+}
+
+inline bool PacketBuffer::is_clone() const {
+    return direct_ != nullptr;
+}
+
+inline PacketBuffer* PacketBuffer::direct_buffer() const {
+    return direct_;
+}
+
+inline PacketBuffer* PacketBuffer::next_buffer() const {
+    return next_;
+}
+
+inline void PacketBuffer::set_next_buffer(PacketBuffer* next) {
+    next_ = next;
+}
+
+inline void PacketBuffer::append_segment(PacketBuffer* tail) {
+    last_segment()->next_ = tail;
+}
+
+inline PacketBuffer* PacketBuffer::last_segment() {
+    PacketBuffer* segment = this;
+    while (segment->next_) {
+        segment = segment->next_;
+    }
+    return segment;
+}
+
+inline PacketBuffer::SegmentRange PacketBuffer::segments() {
+    return SegmentRange{this};
+}
+
+inline size_t PacketBuffer::pkt_len() const {
+    size_t len = 0;
+    for (const PacketBuffer* segment = this; segment; segment = segment->next_) {
+        len += segment->data_len_;
+    }
+    return len;
+}
+
+inline size_t PacketBuffer::nb_segs() const {
+    size_t count = 0;
+    for (const PacketBuffer* segment = this; segment; segment = segment->next_) {
+        ++count;
+    }
+    return count;
+}
+
+inline BufferMetadata* PacketBuffer::metadata() {
+    return metadata_;
+}
+
+inline int PacketBuffer::get_numa_node() const {
+    return numa_node_;
+}
+
+inline PacketBufferPool* PacketBuffer::get_owning_pool() const {
+    return owning_pool_;
+}
+
 #endif // PACKET_BUFFER_HPP
@@ -2,40 +2,290 @@
 #define PACKET_BUFFER_POOL_HPP
 
 #include "packet_buffer.hpp" // Assumes PacketBuffer definition is complete
+#include "lockfree_free_list.hpp"
+#include "buffer_handle.hpp"
+#include "pool_memory.hpp"
+#include "pool_telemetry.hpp"
+#include "sharded_counters.hpp"
 #include <vector>
 #include <cstddef> // For size_t
-#include <mutex>   // For current std::vector-based free_list_
+#include <cstdint> // For uint32_t
+#include <memory>  // For std::unique_ptr
 #include <atomic>  // For statistics
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
 
 // Forward declaration if PoolManager uses it, or include if PoolManager members are here
 // class PoolManager; 
 
+// FR-002: chunked pool growth. With max_count above the initial count the pool reserves
+// index space for max_count buffers up front and, whenever an allocation leaves at most
+// low_watermark buffers free, wakes its maintenance thread, which maps and pre-faults
+// another growth_step buffers (same backing and NUMA node as the initial slab) and splices
+// them into the free list. The allocating thread never maps memory itself.
+struct PoolGrowthPolicy {
+    size_t max_count = 0;     // Upper bound on buffers; <= initial_count disables growth
+    size_t growth_step = 0;   // Buffers added (or revived from parked regions) per refill;
+                              // 0 means initial_count (or 64 if that is 0)
+    size_t low_watermark = 0; // Grow once free buffers drop to this; 0 only when the pool runs dry
+};
+
+// Returning idle memory to the OS. The slab (and every grown chunk) is split into regions
+// of whole buffer units, each counting how many of its buffers are on the shared free
+// list. A region whose buffers are all on it at every scan of the maintenance thread for
+// idle_period is parked: its pages go back to the kernel, and its indices are dropped by
+// whichever allocator pops them next. Scans never take the free list away from
+// allocators. Parked regions are the first thing revived when the pool runs low (before
+// any new chunk is mapped); revival rebuilds the buffer headers and the data pages
+// refault lazily as packets are written. Buffers parked in thread caches keep their
+// region resident.
+struct PoolShrinkPolicy {
+    std::chrono::milliseconds idle_period{0}; // 0 disables shrinking
+    size_t region_bytes = 0;                  // 0 means 64KiB; at least one page of the backing
+    bool lazy_free = false;                   // MADV_FREE instead of MADV_DONTNEED where possible
+};
+
+// Remote frees. A buffer freed by a thread running on a different NUMA node than the
+// pool's is staged in a small per-(thread, pool) return queue instead of going straight
+// onto the pool's shared free list, and the queue is pushed home in one CAS once it holds
+// batch_size buffers, so the remote free-list head line crosses the interconnect once per
+// batch rather than once per buffer. Staged buffers are unavailable to allocators until
+// the batch is flushed (or the freeing thread calls flush_thread_cache()). Only pools with
+// a NUMA node (numa_node >= 0) have foreign threads.
+struct PoolRemoteFreePolicy {
+    size_t batch_size = 0; // 0 disables; clamped to half the initial pool size
+};
+
+// Point-in-time statistics of one pool (see PacketBufferPool::get_statistics()). Plain
+// data, so a monitoring agent can copy it around freely. Counters are cumulative since
+// the pool was created; individual fields are read without a common lock and may be
+// a few operations apart from each other under load.
+struct PoolStatistics {
+    int numa_node;
+    size_t payload_size;
+    size_t headroom;
+    size_t tailroom;
+    MemoryBacking memory_backing; // Obtained, after any fallback
+    bool numa_bound;
+    size_t memory_footprint;      // Bytes mapped for all chunks
+    size_t released_bytes;        // Currently handed back to the kernel (shrinking)
+    size_t total_bytes_returned;
+    size_t initial_count;
+    size_t total_count;           // Buffers owned, including grown chunks and parked ones
+    size_t max_count;
+    size_t free_count;
+    size_t in_use_count;
+    size_t high_water_mark;
+    uint64_t alloc_count;
+    uint64_t free_count_total;    // Buffers returned (dealloc count)
+    uint64_t alloc_failures;      // allocate_buffer()/allocate_bulk() calls that came back empty
+    uint64_t cache_hits;          // Buffers served from a thread cache without touching the free list
+    uint64_t cache_misses;        // Buffers whose allocation had to refill a thread cache first
+    uint64_t remote_frees;        // Buffers returned through a remote-free queue
+    double cache_hit_rate;        // hits / (hits + misses); 0 with no thread-cache traffic
+    double utilization;           // in_use_count / max_count: how close the pool is to running dry
+};
+
 class PacketBufferPool {
 public:
+    // Every buffer unit, and the data area inside it, is aligned to this.
+    static constexpr size_t kCacheLineSize = 64;
+
     PacketBufferPool(size_t buffer_payload_size, // Actual data capacity for packets
                      size_t initial_count, 
                      int numa_node = -1, 
                      size_t headroom = 64, 
-                     size_t tailroom = 0);
-    ~PacketBufferPool();
+                     size_t tailroom = 0,
+                     size_t per_thread_cache_size = 0, // 0 disables the per-thread caches
+                     MemoryBacking memory_backing = MemoryBacking::Default, // Requested slab page backing
+                     const PoolGrowthPolicy& growth = PoolGrowthPolicy(),
+                     const PoolShrinkPolicy& shrink = PoolShrinkPolicy(),
+                     const PoolRemoteFreePolicy& remote_free = PoolRemoteFreePolicy());
+    virtual ~PacketBufferPool();
 
+    PacketBufferPool(const PacketBufferPool&) = delete;
+    PacketBufferPool& operator=(const PacketBufferPool&) = delete;
+
+    // Both are lock-free and safe to call concurrently from any number of threads.
+    // With per-thread caching enabled they first try the calling thread's cache and only
+    // touch the shared free list in bulk, when the cache runs empty or overflows.
     PacketBuffer* allocate_buffer();
-    void deallocate_buffer(PacketBuffer* buffer); // Called by PacketBuffer::release()
+    virtual void deallocate_buffer(PacketBuffer* buffer); // Called by PacketBuffer::release()
+
+    // Burst variants for RX/TX loops. allocate_bulk is all-or-nothing: it either fills
+    // out[0..n) with buffers (ref_count 1 each) and returns true, or hands out nothing and
+    // returns false. free_bulk drops one reference from each buffer, exactly like calling
+    // release() on each, but returns the ones that reach zero to the free list in bulk.
+    // Buffers from other pools are released individually; null entries are skipped.
+    bool allocate_bulk(PacketBuffer** out, size_t n);
+    void free_bulk(PacketBuffer* const* bufs, size_t n);
+
+    // Returns every buffer held in the calling thread's cache, and any frees staged in its
+    // remote-free queue, to the shared free list. Buffers parked in either are only visible
+    // to the thread owning it (or to the next thread handed the same ThreadSlot), so
+    // long-lived idle threads should call this.
+    void flush_thread_cache();
+
+    // Adds up to additional_count buffers (capped at the policy's max_count) in one new
+    // pre-faulted chunk. Normally run by the growth thread; may also be called directly to
+    // grow ahead of an expected burst. Returns false if nothing could be added.
+    bool expand_pool(size_t additional_count);
 
     size_t get_buffer_payload_size() const; // Returns configured payload size
     size_t get_initial_pool_count() const; // Total number of buffers this pool was created with
+    size_t get_total_count() const;        // Buffers currently owned, including grown chunks
+    size_t get_max_count() const;          // Growth limit (== initial count when growth is off)
     size_t get_free_count() const;
     int get_numa_node() const;
     size_t get_headroom_size() const;
     size_t get_tailroom_size() const;
+    size_t get_per_thread_cache_size() const; // Effective size after clamping to the pool size
+    size_t get_remote_free_batch_size() const; // Effective batch after clamping; 0 when off
+    MemoryBacking get_memory_backing() const; // Backing actually obtained, after any fallback
+    size_t get_memory_footprint() const;      // Bytes mapped for all chunks (includes hugepage rounding)
+
+    // NUMA placement of the slab. is_numa_bound() is false when numa_node is -1 or not an
+    // online node; the pool then works as before with first-touch placement.
+    bool is_numa_bound() const;
+    // Actual node of every slab page (see PoolMemory::page_nodes()), initial slab first
+    // and then each grown chunk, for verification.
+    std::vector<int> get_page_numa_nodes() const;
 
     // Basic statistics
     size_t get_alloc_count() const;
     size_t get_dealloc_count() const;
-    // size_t get_high_water_mark() const; // Requires tracking: current_allocated_count_
+    size_t get_in_use_count() const;     // Buffers handed out and not yet returned
+    // Peak in-use count. Growable and shrinkable pools, and any pool while telemetry is
+    // enabled, raise it on every change of the in-use estimate (allocations served from a
+    // thread cache count when the cache next refills, spills or is flushed, so a peak held
+    // entirely in thread caches may read low by up to one cache per thread). Other pools
+    // keep the allocation path free of shared writes and raise it only when an allocation
+    // finds the pool exhausted; reading it always covers the current in-use count.
+    size_t get_high_water_mark() const;
+
+    // Telemetry, off by default and switchable at runtime. While enabled, allocate_buffer()
+    // latency goes into a log-bucketed cycle histogram, the samples' interval high-water
+    // mark is tracked on every allocation, and the maintenance thread appends an
+    // OccupancySample to a fixed ring every sample_interval. While disabled the
+    // allocation path pays one flag check.
+    void enable_telemetry(const PoolTelemetryConfig& config = PoolTelemetryConfig());
+    void disable_telemetry();
+    bool is_telemetry_enabled() const;
+    void sample_occupancy(); // Appends one sample now (the maintenance thread calls this too)
+    std::vector<OccupancySample> get_occupancy_history() const; // Oldest first
+    LatencyHistogram get_allocation_latency() const;            // Since telemetry was first enabled
+
+    size_t get_alloc_failure_count() const;
+    size_t get_remote_free_count() const; // Buffers freed through remote-free queues
+
+    // All of the above in one snapshot. Never blocks allocation or growth.
+    PoolStatistics get_statistics() const;
+
+    // 32-bit handles (see BufferHandle). Pools of up to BufferHandle::kMaxIndex + 1 buffers
+    // (counting growth) get a handle pool id at construction, while fewer than
+    // BufferHandle::kMaxPools pools are alive; other pools issue only invalid handles.
+    // Decoding is a bounds check and two table loads, with no lock.
+    bool has_handles() const { return handle_pool_id_ != kNoHandlePoolId; }
+    uint32_t get_handle_pool_id() const { return handle_pool_id_; }
+    BufferHandle to_handle(const PacketBuffer* buffer) const {
+        if (!buffer || buffer->owning_pool_ != this || !has_handles()) {
+            return BufferHandle();
+        }
+        return BufferHandle::make(handle_pool_id_, buffer->pool_index_);
+    }
+    // nullptr unless the handle was issued by this pool, or if its buffer sits in a region
+    // that has been handed back to the kernel. A pool without handles has the reserved id
+    // as its handle_pool_id_, so that is checked before the ids are compared.
+    PacketBuffer* from_handle(BufferHandle handle) const {
+        if (!has_handles() || !handle.valid() || handle.pool_id() != handle_pool_id_ ||
+            handle.index() >= buffer_count_.load(std::memory_order_acquire) ||
+            in_parked_region(handle.index())) {
+            return nullptr;
+        }
+        return buffers_[handle.index()];
+    }
+    // Decodes a handle from any live pool; nullptr for an invalid handle, a pool id no
+    // pool can hold, or a retired id.
+    static PacketBuffer* resolve(BufferHandle handle) {
+        if (!handle.valid() || handle.pool_id() >= BufferHandle::kMaxPools) {
+            return nullptr;
+        }
+        const PacketBufferPool* pool = handle_pools_[handle.pool_id()].load(std::memory_order_acquire);
+        return pool ? pool->from_handle(handle) : nullptr;
+    }
+
+    // Shrink statistics
+    size_t get_released_buffer_count() const; // Buffers currently parked in released regions
+    size_t get_released_bytes() const;        // Bytes currently handed back to the kernel
+    size_t get_total_bytes_returned() const;  // Cumulative bytes handed back (never decreases)
 
 private:
+    // One per ThreadSlot; only the owning thread touches it, so no atomics are needed.
+    // alignas keeps neighbouring threads' caches off each other's cache lines. Remote-free
+    // queues use the same layout.
+    struct alignas(64) ThreadCache {
+        uint32_t len = 0;         // Number of valid entries in objs
+        uint32_t* objs = nullptr; // cache_flush_threshold_ slots in cache_storage_ (LIFO)
+        int64_t in_use_delta = 0; // Allocations minus frees not yet added to in_use_estimate_
+    };
+
+    // A run of whole buffer units inside one chunk (0: pool_memory_, k: growth_chunks_[k-1]).
+    struct Region {
+        size_t first_index;
+        size_t count;
+        size_t chunk;
+        std::chrono::steady_clock::time_point free_since{}; // Epoch while not observed all-free
+        bool released = false;
+        size_t released_bytes = 0;
+    };
+
+    // Latency counters are sharded by ThreadSlot so concurrent recorders rarely share a line.
+    static constexpr size_t kLatencyShards = 16;
+    struct alignas(64) LatencyShard {
+        std::atomic<uint64_t> counts[LatencyHistogram::kBucketCount];
+    };
+
+    PacketBuffer* allocate_untimed(); // allocate_buffer() without telemetry
+    void note_in_use(size_t in_use);  // Raises the interval and lifetime high-water marks
+    void raise_high_water_mark(size_t in_use);
+    void note_exhausted();            // Failure statistics for an allocation that came back empty
+    void add_in_use(int64_t delta);   // No-op unless tracks_in_use(); raises the high-water mark
+    void publish_in_use(ThreadCache& cache);
+    size_t in_use_estimate() const;
+    size_t free_estimate() const;     // get_free_count() from in_use_estimate_
+
     bool initialize_pool(); // Helper to allocate and set up all buffers
+    void construct_units(unsigned char* block, size_t first_index, size_t count);
+    void destroy_units(size_t first_index, size_t count);
+    unsigned char* unit_start(size_t index) const;
+    void push_free_range(size_t first_index, size_t count); // Lowest index ends up on top
+    void add_regions(size_t chunk, size_t first_index, size_t count); // Assumes chunk_mutex_ is held
+    PoolMemory& chunk_memory(size_t chunk);
+    bool revive_regions(size_t want);                  // Unparks released regions, lowest first
+    void shrink_idle_regions();                        // One pass over the region counts
+    void push_shared(const uint32_t* indices, size_t count); // free_list_ push, counted per region
+    uint32_t pop_shared();                             // free_list_ pop that skips parked regions
+    size_t pop_bulk_shared(uint32_t* out, size_t max_count);
+    size_t claim_popped(uint32_t* indices, size_t count);
+    void request_refill_if_low(bool exhausted = false); // Hot-path check; only wakes maintenance_thread_
+    bool refill_enabled() const { return max_count_ > initial_pool_count_ || shrink_enabled(); }
+    bool shrink_enabled() const { return shrink_idle_period_.count() > 0; }
+    bool tracks_in_use() const { return refill_enabled() || telemetry_enabled_.load(std::memory_order_relaxed); }
+    bool in_parked_region(size_t index) const {
+        return shrink_enabled() &&
+               (region_free_[region_of_[index]].load(std::memory_order_acquire) & kRegionParked) != 0;
+    }
+    void maintenance_worker();
+    void initialize_thread_caches();
+    void initialize_remote_queues();
+    void register_handle_pool_id();
+    ThreadCache* local_cache(); // Calling thread's cache, or nullptr if caching is off / no slot
+    ThreadCache* remote_queue(); // Calling thread's return queue if it is foreign to this pool
+    PacketBuffer* prepare_allocated(uint32_t index);
+    void return_indices(const uint32_t* indices, size_t count); // Through the thread cache if enabled
+    void detach_clone(PacketBuffer* buffer); // Undoes PacketBuffer::clone() on a freed clone
 
     // Configuration stored from constructor
     size_t buffer_payload_size_; // User-requested payload size
@@ -45,21 +295,110 @@ private:
     size_t tailroom_size_;
 
     // Calculated size for the entire memory block for one buffer unit
-    // (metadata + PacketBuffer obj + headroom + payload + tailroom)
+    // (metadata + PacketBuffer obj + headroom + payload + tailroom), a multiple of kCacheLineSize
     size_t single_buffer_unit_alloc_size_; 
 
-    // Raw memory for all buffers in this pool.
-    // This pointer owns the memory for all PacketBuffer objects and their data.
+    // Raw memory for all buffers in this pool, kCacheLineSize aligned.
+    // pool_memory_ owns the mapping holding all PacketBuffer objects and their data;
+    // pool_memory_block_ is its start.
+    MemoryBacking requested_memory_backing_;
+    PoolMemory pool_memory_;
     unsigned char* pool_memory_block_ = nullptr; 
-                                             
-    std::vector<PacketBuffer*> free_list_; // Simple free list using std::vector
-    std::mutex list_mutex_; // Protects free_list_
-
-    std::atomic<size_t> alloc_count_{0};
-    std::atomic<size_t> dealloc_count_{0};
-    // std::atomic<size_t> current_allocated_count_{0}; // For high_water_mark, can be added later
-    
-    // FR-002: Pool expansion related (placeholders for now)
-    // bool expand_pool(size_t additional_count);
+
+    // Index -> buffer, sized for max_count_ up front so growth never moves it. Entries
+    // [0, buffer_count_) are set; a grown entry is written before its index is pushed onto
+    // free_list_, whose release/acquire pairing publishes it to the allocating thread.
+    std::unique_ptr<PacketBuffer*[]> buffers_;
+    std::atomic<size_t> buffer_count_{0};
+    LockFreeFreeList free_list_;         // Indices into buffers_ of the currently free buffers
+
+    // Handle pool ids: handle_pools_[id] is the live pool registered under id, or null.
+    static constexpr uint32_t kNoHandlePoolId = BufferHandle::kMaxPools;
+    static inline std::atomic<const PacketBufferPool*> handle_pools_[BufferHandle::kMaxPools] = {};
+    uint32_t handle_pool_id_ = kNoHandlePoolId;
+
+    // Per-thread caches in front of free_list_ (mempool-style). A cache is refilled with
+    // per_thread_cache_size_ entries when empty and spills back down to that size once it
+    // reaches cache_flush_threshold_ (1.5x), so steady alloc/free traffic stays thread-local.
+    size_t per_thread_cache_size_ = 0;
+    size_t cache_flush_threshold_ = 0;
+    std::unique_ptr<ThreadCache[]> thread_caches_;  // ThreadSlot::kMaxSlots entries when enabled
+    std::unique_ptr<uint32_t[]> cache_storage_;
+
+    // Remote-free return queues (see PoolRemoteFreePolicy), ThreadSlot::kMaxSlots entries
+    // of remote_free_batch_ indices each when enabled.
+    size_t remote_free_batch_ = 0;
+    std::unique_ptr<ThreadCache[]> remote_queues_;
+    std::unique_ptr<uint32_t[]> remote_storage_;
+
+    // Statistics, sharded by ThreadSlot so allocating and freeing threads never write a
+    // shared line; getters sum the shards.
+    enum Stat : size_t {
+        kStatAllocs,
+        kStatDeallocs,
+        kStatAllocFailures,
+        kStatCacheHits,
+        kStatCacheMisses,
+        kStatRemoteFrees,
+        kStatCount
+    };
+    ShardedCounters<kStatCount> stats_;
+    std::atomic<size_t> high_water_mark_{0};
+
+    // Buffers handed out, kept for the hot-path checks (low watermark, high-water mark)
+    // that cannot afford summing stats_ over every shard. The shared-list paths update it
+    // directly; thread-cache and remote-queue traffic accumulates in the ThreadCache and is
+    // added in one go whenever that cache or queue next touches the shared list, so it
+    // trails the exact count by at most about one cache's worth of buffers per thread.
+    // Kept only while something reads it (tracks_in_use(): the refill watermark check of
+    // growable or shrinkable pools, and telemetry), because without a thread cache it costs
+    // a shared-line RMW on every allocation and free.
+    alignas(64) std::atomic<int64_t> in_use_estimate_{0};
+
+    // Telemetry. latency_shards_ and the ring are allocated on the first enable and the
+    // shards are kept for the pool's lifetime, so a recorder that raced with
+    // disable_telemetry() never touches freed memory. telemetry_mutex_ guards the ring.
+    std::atomic<bool> telemetry_enabled_{false};
+    std::atomic<size_t> interval_high_water_{0};
+    std::atomic<int64_t> sample_interval_ms_{0};
+    std::unique_ptr<LatencyShard[]> latency_shards_;
+    mutable std::mutex telemetry_mutex_;
+    std::vector<OccupancySample> occupancy_ring_;
+    size_t occupancy_next_ = 0;  // Ring slot the next sample goes to
+    size_t occupancy_count_ = 0; // Valid samples, up to occupancy_ring_.size()
+
+    // FR-002: pool growth. chunk_mutex_ serializes expand_pool(), shrink scans and revival,
+    // and guards growth_chunks_ and regions_.
+    size_t max_count_;
+    size_t growth_step_;
+    size_t low_watermark_;
+    mutable std::mutex chunk_mutex_;
+    std::vector<PoolMemory> growth_chunks_;
+    std::atomic<size_t> mapped_bytes_{0}; // pool_memory_ plus growth_chunks_, readable without the lock
+
+    // Shrinking (see PoolShrinkPolicy). regions_ covers every unit when shrinking is on.
+    // region_free_[r] counts region r's indices on the shared free list (bumped before a
+    // push, dropped after a pop); once kRegionParked is set, the rest of the count is the
+    // region's stale indices still on the list. Both arrays are sized for max_count_
+    // up front so the lock-free paths never see them move.
+    static constexpr uint32_t kRegionParked = 0x80000000u;
+    std::chrono::milliseconds shrink_idle_period_;
+    size_t shrink_region_bytes_;
+    bool shrink_lazy_free_;
+    std::vector<Region> regions_;
+    std::unique_ptr<uint32_t[]> region_of_;                 // Index -> region
+    std::unique_ptr<std::atomic<uint32_t>[]> region_free_; // By region
+    std::atomic<size_t> released_buffer_count_{0};
+    std::atomic<size_t> released_bytes_{0};
+    std::atomic<size_t> total_bytes_returned_{0};
+
+    // Maintenance thread (growth, revival, shrink scans and occupancy sampling), started
+    // when one of them is enabled. Allocating threads set refill_requested_ (once per episode) and notify; the
+    // timed wait covers a notify that lands between the worker's check and its wait.
+    std::atomic<bool> refill_requested_{false};
+    std::mutex maintenance_mutex_;
+    std::condition_variable maintenance_cv_;
+    bool maintenance_stop_ = false;
+    std::thread maintenance_thread_;
 };
 #endif // PACKET_BUFFER_POOL_HPP
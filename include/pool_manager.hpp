@@ -3,33 +3,131 @@
 
 #include "packet_buffer.hpp"       // For PacketBuffer type
 #include "packet_buffer_pool.hpp"  // For PacketBufferPool type
+#include "rcu_domain.hpp"
+#include "event_log.hpp"
 #include <vector>
 #include <map>
 #include <mutex>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
 #include <memory> // For std::unique_ptr
+#include <thread>
 
 struct PoolConfig {
     size_t buffer_size;     // Payload size
     size_t initial_count;
     size_t headroom = 64;   // Default, can be overridden
     size_t tailroom = 0;    // Default
+    size_t per_thread_cache_size = 0; // Buffers cached per thread in front of the shared free list; 0 disables
+    MemoryBacking memory_backing = MemoryBacking::Default; // Hugepage backing falls back to THP, then 4K pages
+    PoolGrowthPolicy growth{};  // Chunked growth in the background; off unless growth.max_count > initial_count
+    PoolShrinkPolicy shrink{};  // Returns idle regions to the OS; off unless shrink.idle_period > 0
+    PoolRemoteFreePolicy remote_free{}; // Batches frees from other nodes' threads; off unless batch_size > 0
     // int numa_node = -1; // If not specified per-pool here, manager can assign it
 };
 
+// Snapshot of every pool the manager serves, one PoolStatistics per (node, size class),
+// ordered by node (-1, the global pools, first) and then payload size. The per-pool
+// entries live in storage the caller passes to PoolManager::get_statistics(), so polling
+// allocates nothing once that storage is large enough; a snapshot taken into too little
+// storage says so through truncated() rather than silently dropping pools.
+struct PoolManagerStatistics {
+    size_t pool_count;          // Pools the manager serves
+    size_t pools_filled;        // Entries written to pools: min(pool_count, capacity)
+    PoolStatistics* pools;      // The caller's storage
+    uint64_t events_recorded;   // Allocation-failure events logged (see event_log())
+    uint64_t events_suppressed; // ... rate-limited away
+    uint64_t events_dropped;    // ... lost to a full event ring
+
+    bool truncated() const { return pools_filled < pool_count; }
+};
+
+// Background statistics sampling (PoolManager::set_statistics_callback). A pool's alert
+// is raised when its utilization goes above raise_utilization and cleared only once it
+// has dropped to clear_utilization or below, so a pool hovering at the threshold does not
+// fire on every sample.
+struct StatisticsCallbackConfig {
+    std::chrono::milliseconds interval{1000};
+    double raise_utilization = 0.90;
+    double clear_utilization = 0.80;
+};
+
+struct UtilizationAlert {
+    int numa_node;
+    size_t payload_size;
+    double utilization; // The sample that crossed the threshold
+    bool raised;        // true: crossed raise_utilization; false: fell back to clear_utilization
+};
+
 class PoolManager {
 public:
+    // Pass as numa_node to allocate from the calling thread's own node (resolved with
+    // NumaTopology::current_node()). Pools are tried node by node in that node's fallback
+    // order -- nearest SLIT distance first unless overridden with set_numa_fallback_order --
+    // moving on when a node has no suitable pool or its pool is exhausted, and finally the
+    // global (-1) pools.
+    static constexpr int kCurrentNode = -2;
+
     static PoolManager& instance();
 
     // Configuration
-    // Configure pools for a specific NUMA node, or globally if numa_node is -1
+    // Configure pools for a specific NUMA node, or globally if numa_node is -1. Throws
+    // std::invalid_argument for any other negative node (such as kCurrentNode).
     bool configure_pools_for_numa_node(int numa_node, const std::vector<PoolConfig>& configs);
     // Simpler configuration for a single pool type on a given NUMA node
     bool add_pool(int numa_node, const PoolConfig& config);
 
+    // Replaces the kCurrentNode fallback order for threads running on `node`. The list is
+    // used as given (include `node` itself, normally first); an empty list restores the
+    // distance-based default. The global pools are always tried last.
+    void set_numa_fallback_order(int node, const std::vector<int>& order);
+
     PacketBuffer* allocate(size_t desired_payload_size, int numa_node = -1);
     void deallocate(PacketBuffer* buffer); // May not be the primary path
 
-    void print_stats() const; // For diagnostics
+    // Burst variants: one pool lookup and one lock round-trip per burst instead of per buffer.
+    // allocate_bulk is all-or-nothing (see PacketBufferPool::allocate_bulk); every buffer
+    // comes from the same pool. free_bulk accepts buffers from any mix of pools.
+    bool allocate_bulk(PacketBuffer** out, size_t n, size_t desired_payload_size, int numa_node = -1);
+    void free_bulk(PacketBuffer* const* bufs, size_t n);
+
+    // 32-bit handle <-> pointer conversion for buffers from any of the manager's pools
+    // (see BufferHandle). to_handle() returns an invalid handle for a buffer whose pool
+    // cannot issue handles; from_handle() returns nullptr for an invalid handle.
+    static BufferHandle to_handle(const PacketBuffer* buffer) {
+        const PacketBufferPool* pool = buffer ? buffer->get_owning_pool() : nullptr;
+        return pool ? pool->to_handle(buffer) : BufferHandle();
+    }
+    static PacketBuffer* from_handle(BufferHandle handle) { return PacketBufferPool::resolve(handle); }
+
+    // Gathers PoolStatistics for every pool from the published RCU snapshot: it neither
+    // takes manager_mutex_ nor waits for allocations, reconfiguration or pool growth, so it
+    // is cheap enough to poll every few milliseconds. Fills at most `capacity` entries of
+    // `pools`; size the storage with get_pool_count(). The vector form grows `pools` until
+    // every pool fits (pools can be added concurrently) and reuses it on later calls.
+    size_t get_pool_count() const;
+    PoolManagerStatistics get_statistics(PoolStatistics* pools, size_t capacity) const;
+    PoolManagerStatistics get_statistics(std::vector<PoolStatistics>& pools) const;
+
+    void print_stats() const; // For diagnostics: get_statistics() formatted to std::cout
+
+    using StatisticsCallback = std::function<void(const PoolManagerStatistics& stats)>;
+    using UtilizationAlertCallback = std::function<void(const UtilizationAlert& alert)>;
+
+    // Starts a sampler thread that takes a get_statistics() snapshot every config.interval,
+    // passes it to on_sample (if set), then calls on_alert (if set) for each pool whose
+    // utilization crossed a threshold since the previous sample. Callbacks run on the
+    // sampler thread and must not call set/clear_statistics_callback themselves. Replaces
+    // any callbacks set before; alert state starts afresh.
+    void set_statistics_callback(StatisticsCallback on_sample, UtilizationAlertCallback on_alert = {},
+                                 const StatisticsCallbackConfig& config = {});
+    void clear_statistics_callback(); // Stops the sampler thread, if any
+
+    // Allocation failures are recorded here instead of being printed: the allocation paths
+    // never touch iostreams. Drain it on demand or call start_background_drain() on it.
+    EventLog& event_log() { return event_log_; }
 
 private:
     PoolManager();
@@ -40,9 +138,34 @@ private:
 
     // Key: NUMA node ID (-1 for 'any' or 'unspecified', or if NUMA is not supported/detected)
     // Value: Map of (buffer_payload_size -> PacketBufferPool unique_ptr)
+    // Owns the pools and is only touched by writers. Pools are never removed, so pool
+    // pointers taken from any snapshot stay valid for the manager's lifetime.
     std::map<int, std::map<size_t, std::unique_ptr<PacketBufferPool>>> numa_pools_;
-    mutable std::mutex manager_mutex_; // Protects numa_pools_
+    mutable std::mutex manager_mutex_; // Serializes writers; protects numa_pools_ and numa_fallback_order_
+
+    // Explicit set_numa_fallback_order() overrides, keyed by local node.
+    std::map<int, std::vector<int>> numa_fallback_order_;
+
+    // Read-copy-update pool topology. Each configuration change builds a new immutable
+    // SizeClassTable from numa_pools_ and the fallback orders, swaps it in atomically, waits
+    // for an RCU grace period and frees the old one. Readers (allocate, allocate_bulk,
+    // print_stats) only enter an rcu_ read-side section and load the pointer; they never
+    // wait for a writer, even one that is busy creating and pre-faulting a large pool.
+    struct SizeClassTable;
+    std::atomic<const SizeClassTable*> size_class_table_{nullptr};
+    mutable RcuDomain rcu_;
+
+    EventLog event_log_;
+
+    // Statistics sampler thread (set_statistics_callback).
+    std::mutex sampler_control_mutex_; // Serializes starting and stopping the sampler
+    std::mutex sampler_mutex_; // Guards sampler_stop_; held only to sleep on / wake the sampler
+    std::condition_variable sampler_cv_;
+    bool sampler_stop_ = false;
+    std::thread sampler_thread_;
+    void run_statistics_sampler(StatisticsCallback on_sample, UtilizationAlertCallback on_alert,
+                                StatisticsCallbackConfig config);
 
-    PacketBufferPool* find_pool(size_t desired_payload_size, int numa_node) const;
+    void publish_size_class_table(); // Assumes manager_mutex_ is held; waits for a grace period
 };
 #endif // POOL_MANAGER_HPP
@@ -0,0 +1,74 @@
+#ifndef POOL_MEMORY_HPP
+#define POOL_MEMORY_HPP
+
+#include <cstddef> // For size_t
+#include <vector>
+
+// Page backing for a pool's slab, from most to least preferred when requested.
+enum class MemoryBacking {
+    Default,             // Plain anonymous mapping, 4K pages
+    TransparentHugepage, // Anonymous mapping advised with MADV_HUGEPAGE (THP decides per 2MB range)
+    Hugepage2M,          // hugetlbfs 2MB pages via MAP_HUGETLB
+    Hugepage1G           // hugetlbfs 1GB pages via MAP_HUGETLB
+};
+
+const char* memory_backing_name(MemoryBacking backing);
+
+// Owns one anonymous memory mapping used as (part of) a pool slab.
+//
+// map() tries the requested backing first and falls back transparently:
+// Hugepage1G -> Hugepage2M -> TransparentHugepage -> Default. backing() reports what was
+// actually obtained; a requested hugepage backing that ends up as Default means neither
+// reserved hugepages nor THP were available. Hugepage mappings are rounded up to a whole
+// number of huge pages. The memory is zero-filled and at least page aligned.
+//
+// With numa_node >= 0 the mapping is given a preferred-node memory policy for that node
+// (raw mbind, so libnuma is not needed) before any page is touched. Every mapping is then
+// pre-faulted, so page allocation happens at construction rather than on the first
+// packet. Nodes that are not online are ignored; bound_node() tells whether the policy
+// was applied and page_nodes() where each page really landed.
+class PoolMemory {
+public:
+    PoolMemory() = default;
+    ~PoolMemory();
+
+    PoolMemory(PoolMemory&& other) noexcept;
+    PoolMemory& operator=(PoolMemory&& other) noexcept;
+    PoolMemory(const PoolMemory&) = delete;
+    PoolMemory& operator=(const PoolMemory&) = delete;
+
+    // Returns an empty PoolMemory (data() == nullptr) only if even a plain mapping fails.
+    static PoolMemory map(size_t length, MemoryBacking requested, int numa_node = -1);
+
+    unsigned char* data() const { return base_; }
+    size_t size() const { return length_; }        // Mapped bytes (>= requested length)
+    MemoryBacking backing() const { return backing_; }
+    size_t page_size() const;                       // Page granule of the backing obtained
+    size_t release_granule() const;                 // Alignment release() trims ranges to
+    int bound_node() const { return bound_node_; }  // -1 if no node policy was applied
+
+    // NUMA node of each page (in page_size() steps), as reported by move_pages(2) with no
+    // target nodes; entries are negative errno values for pages the kernel could not report.
+    std::vector<int> page_nodes() const;
+
+    // Returns the whole pages inside [begin, begin + length) to the kernel and reports how
+    // many bytes that was (0 if the range holds no whole page, or madvise fails). The range
+    // stays mapped and refaults on the next touch, zero-filled and under the same node
+    // policy. lazy uses MADV_FREE where the backing allows it (the kernel reclaims only
+    // under memory pressure, and old contents may survive); otherwise MADV_DONTNEED. THP
+    // mappings are trimmed to whole 2MB ranges so no huge page gets split.
+    size_t release(unsigned char* begin, size_t length, bool lazy = false);
+
+private:
+    PoolMemory(unsigned char* base, size_t length, MemoryBacking backing);
+    static PoolMemory map_unplaced(size_t length, MemoryBacking requested);
+    void prefault();
+    void reset();
+
+    unsigned char* base_ = nullptr;
+    size_t length_ = 0;
+    MemoryBacking backing_ = MemoryBacking::Default;
+    int bound_node_ = -1;
+};
+
+#endif // POOL_MEMORY_HPP
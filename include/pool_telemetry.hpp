@@ -0,0 +1,93 @@
+#ifndef POOL_TELEMETRY_HPP
+#define POOL_TELEMETRY_HPP
+
+#include <chrono>
+#include <cstddef> // For size_t
+#include <cstdint> // For uintXX_t types
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h> // For __rdtsc
+#endif
+
+// Runtime-enabled pool telemetry (see PacketBufferPool::enable_telemetry()).
+struct PoolTelemetryConfig {
+    std::chrono::milliseconds sample_interval{100}; // Occupancy sampling period
+    size_t history_length = 256;                    // Occupancy samples kept (fixed ring)
+};
+
+// One occupancy sample. interval_high_water is the peak in-use count seen since the
+// previous sample, so short bursts between samples are not lost.
+struct OccupancySample {
+    uint64_t timestamp_ns = 0; // steady_clock
+    size_t in_use = 0;
+    size_t interval_high_water = 0;
+    size_t total = 0;          // Buffers owned (excluding parked ones) at sample time
+};
+
+// Raw cycle counter used for latency measurement: TSC on x86, steady_clock nanoseconds
+// elsewhere. Only differences are meaningful.
+inline uint64_t read_cycle_counter() {
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    return static_cast<uint64_t>(std::chrono::steady_clock::now().time_since_epoch().count());
+#endif
+}
+
+// Log-linear (HDR-style) histogram of cycle counts: values below kSubBuckets get a bucket
+// each, and every power of two above that is split into kSubBuckets equal buckets, so any
+// recorded value is known to within 1/kSubBuckets (12.5%) of itself. Values at or above
+// 2^kMaxExponent land in the last bucket.
+//
+// This is the snapshot type handed to readers; pools record into sharded atomic counters
+// with the same bucket layout and merge them into one of these on request.
+class LatencyHistogram {
+public:
+    static constexpr unsigned kSubBucketBits = 3;
+    static constexpr size_t kSubBuckets = size_t(1) << kSubBucketBits;
+    static constexpr unsigned kMaxExponent = 40;
+    static constexpr size_t kBucketCount = kSubBuckets + (kMaxExponent - kSubBucketBits) * kSubBuckets;
+
+    static size_t bucket_index(uint64_t value) {
+        if (value < kSubBuckets) {
+            return static_cast<size_t>(value);
+        }
+        const unsigned exponent = 63u - static_cast<unsigned>(__builtin_clzll(value));
+        if (exponent >= kMaxExponent) {
+            return kBucketCount - 1;
+        }
+        const unsigned shift = exponent - kSubBucketBits;
+        const size_t sub = static_cast<size_t>(value >> shift) & (kSubBuckets - 1);
+        return kSubBuckets + shift * kSubBuckets + sub;
+    }
+
+    // Smallest value that maps to bucket `index`.
+    static uint64_t bucket_lower_bound(size_t index) {
+        if (index < kSubBuckets) {
+            return index;
+        }
+        const size_t shift = (index - kSubBuckets) / kSubBuckets;
+        const size_t sub = (index - kSubBuckets) % kSubBuckets;
+        return (uint64_t(kSubBuckets) + sub) << shift;
+    }
+
+    LatencyHistogram() : counts_(kBucketCount, 0) {}
+
+    void record(uint64_t value) { add(bucket_index(value), 1); }
+    void add(size_t bucket, uint64_t count) { counts_[bucket] += count; total_ += count; }
+
+    uint64_t count() const { return total_; }
+    uint64_t bucket_count(size_t bucket) const { return counts_[bucket]; }
+
+    // Lower bound of the bucket holding the given percentile (0..100); 0 if empty.
+    uint64_t value_at_percentile(double percentile) const;
+    uint64_t min() const; // Lower bound of the lowest non-empty bucket
+    uint64_t max() const; // Lower bound of the highest non-empty bucket
+
+private:
+    std::vector<uint64_t> counts_;
+    uint64_t total_ = 0;
+};
+
+#endif // POOL_TELEMETRY_HPP
@@ -0,0 +1,66 @@
+#ifndef PROMETHEUS_EXPORTER_HPP
+#define PROMETHEUS_EXPORTER_HPP
+
+#include "pool_manager.hpp" // For PoolManager, PoolManagerStatistics
+#include <atomic>
+#include <cstddef> // For size_t
+#include <cstdint> // For uint16_t
+#include <memory>  // For std::shared_ptr, std::unique_ptr
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Renders PoolManager statistics as OpenMetrics text (Prometheus exposition format 1.0).
+//
+// Rendering works on a PoolManager::get_statistics() snapshot, so a scrape never takes a
+// lock the data plane uses, and writes into caller-provided memory without allocating.
+// Every pool contributes one sample per metric family, labelled {node="..",size=".."}.
+//
+// The optional HTTP endpoint is a single background thread serving GET /metrics on a
+// loopback address, one connection at a time, out of a body buffer allocated when it
+// starts; nothing is allocated per scrape.
+class PrometheusExporter {
+public:
+    static constexpr const char* kContentType = "application/openmetrics-text; version=1.0.0; charset=utf-8";
+    static constexpr size_t kDefaultBodyCapacity = 256 * 1024;
+
+    static std::shared_ptr<PrometheusExporter> create(PoolManager& manager = PoolManager::instance());
+
+    explicit PrometheusExporter(PoolManager& manager);
+    ~PrometheusExporter();
+
+    PrometheusExporter(const PrometheusExporter&) = delete;
+    PrometheusExporter& operator=(const PrometheusExporter&) = delete;
+
+    // Writes the exposition text for `stats` into out[0..capacity) (always NUL-terminated
+    // when capacity > 0) and returns the length the complete text needs, excluding the
+    // NUL, like snprintf: a result >= capacity means the output was truncated.
+    static size_t render(const PoolManagerStatistics& stats, char* out, size_t capacity);
+
+    // Snapshots the manager and renders it. The per-pool snapshot storage is kept between
+    // calls, so this allocates only when pools have been added since the last render.
+    size_t render(char* out, size_t capacity) const;
+
+    // Serves GET /metrics on bind_address:port (port 0 picks a free one; see http_port()).
+    // Returns false if the socket cannot be set up or a server is already running.
+    bool start_http_server(uint16_t port, const char* bind_address = "127.0.0.1",
+                           size_t body_capacity = kDefaultBodyCapacity);
+    void stop_http_server();
+    uint16_t http_port() const { return http_port_; } // 0 when not running
+
+private:
+    void serve();
+    void handle_connection(int client);
+
+    PoolManager& manager_;
+    mutable std::mutex snapshot_mutex_;          // Guards pools_ (scrapes vs. direct render calls)
+    mutable std::vector<PoolStatistics> pools_; // Reused get_statistics() storage
+    int listen_fd_ = -1;
+    uint16_t http_port_ = 0;
+    std::atomic<bool> http_stop_{false};
+    std::thread http_thread_;
+    std::unique_ptr<char[]> body_; // Scrape buffer, body_capacity_ bytes
+    size_t body_capacity_ = 0;
+};
+
+#endif // PROMETHEUS_EXPORTER_HPP
@@ -0,0 +1,96 @@
+#ifndef RCU_DOMAIN_HPP
+#define RCU_DOMAIN_HPP
+
+#include "thread_slot.hpp"
+#include <atomic>
+#include <cstddef> // For size_t
+#include <cstdint> // For uint64_t
+
+// Minimal epoch-based read-copy-update domain.
+//
+// Readers bracket their use of an RCU-published pointer with read_lock()/read_unlock()
+// (or a ReadGuard). They never block and never write shared cache lines: each thread only
+// stores to its own ThreadSlot entry. Writers publish a new version, call synchronize() to
+// wait out a grace period -- until every reader that might still see the old version has
+// left its critical section -- and then free the old version.
+//
+// The reader's StoreLoad ordering (announce epoch, then load the pointer) is normally a
+// full fence. When the kernel supports membarrier(MEMBARRIER_CMD_PRIVATE_EXPEDITED), the
+// writer issues that instead and readers only need a compiler barrier, moving the whole
+// cost to the (rare) writer.
+class RcuDomain {
+public:
+    RcuDomain();
+
+    RcuDomain(const RcuDomain&) = delete;
+    RcuDomain& operator=(const RcuDomain&) = delete;
+
+    void read_lock() {
+        size_t slot = ThreadSlot::current();
+        if (slot == ThreadSlot::kNone) {
+            slotless_read_lock();
+            return;
+        }
+        ReaderState& reader = readers_[slot];
+        if (reader.nesting++ == 0) {
+            reader.epoch.store(global_epoch_.load(std::memory_order_relaxed), std::memory_order_relaxed);
+            reader_fence();
+        }
+    }
+
+    void read_unlock() {
+        size_t slot = ThreadSlot::current();
+        if (slot == ThreadSlot::kNone) {
+            slotless_read_unlock();
+            return;
+        }
+        ReaderState& reader = readers_[slot];
+        if (--reader.nesting == 0) {
+            reader.epoch.store(kQuiescent, std::memory_order_release);
+        }
+    }
+
+    // Blocks until every read-side critical section that started before the call has
+    // ended. Must not be called from inside a read-side critical section.
+    void synchronize();
+
+    class ReadGuard {
+    public:
+        explicit ReadGuard(RcuDomain& domain) : domain_(domain) { domain_.read_lock(); }
+        ~ReadGuard() { domain_.read_unlock(); }
+        ReadGuard(const ReadGuard&) = delete;
+        ReadGuard& operator=(const ReadGuard&) = delete;
+    private:
+        RcuDomain& domain_;
+    };
+
+private:
+    static constexpr uint64_t kQuiescent = 0;
+
+    // One per ThreadSlot; only the owning thread writes it. Padded so readers on
+    // different cores never share a line.
+    struct alignas(64) ReaderState {
+        std::atomic<uint64_t> epoch{kQuiescent}; // Epoch observed at read_lock, or kQuiescent
+        uint32_t nesting = 0;
+    };
+
+    void reader_fence() {
+        if (use_membarrier_) {
+            std::atomic_signal_fence(std::memory_order_seq_cst);
+        } else {
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+        }
+    }
+
+    void slotless_read_lock();
+    void slotless_read_unlock();
+
+    bool use_membarrier_ = false;
+    alignas(64) std::atomic<uint64_t> global_epoch_{1};
+    // Threads beyond ThreadSlot::kMaxSlots share this counter; synchronize() waits for
+    // it to drain. Slow but only reachable with more than kMaxSlots live threads.
+    alignas(64) std::atomic<uint64_t> slotless_readers_{0};
+    ReaderState readers_[ThreadSlot::kMaxSlots];
+};
+
+#endif // RCU_DOMAIN_HPP
@@ -0,0 +1,58 @@
+#ifndef SHARDED_COUNTERS_HPP
+#define SHARDED_COUNTERS_HPP
+
+#include "thread_slot.hpp"
+#include <atomic>
+#include <cstddef> // For size_t
+#include <cstdint> // For uint64_t
+#include <memory>  // For std::unique_ptr
+
+// A set of N statistics counters sharded by ThreadSlot and summed on read.
+//
+// Each slot owns a cache-line aligned shard that only its thread writes, so add() is a
+// plain load and store (no locked RMW) on a line no other core writes; threads without a
+// slot share one extra shard and pay a fetch_add. Readers sum the shards of every slot
+// handed out so far; a sum taken during concurrent updates is a momentary approximation,
+// as with any relaxed counter.
+template <size_t N>
+class ShardedCounters {
+public:
+    ShardedCounters() : shards_(new Shard[ThreadSlot::kMaxSlots + 1]) {
+        for (size_t slot = 0; slot <= ThreadSlot::kMaxSlots; ++slot) {
+            for (std::atomic<uint64_t>& value : shards_[slot].values) {
+                value.store(0, std::memory_order_relaxed);
+            }
+        }
+    }
+
+    ShardedCounters(const ShardedCounters&) = delete;
+    ShardedCounters& operator=(const ShardedCounters&) = delete;
+
+    void add(size_t counter, uint64_t n = 1) {
+        const size_t slot = ThreadSlot::current(); // kNone == kMaxSlots: the shared shard
+        std::atomic<uint64_t>& value = shards_[slot].values[counter];
+        if (slot != ThreadSlot::kNone) {
+            value.store(value.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+        } else {
+            value.fetch_add(n, std::memory_order_relaxed);
+        }
+    }
+
+    uint64_t sum(size_t counter) const {
+        uint64_t total = shards_[ThreadSlot::kNone].values[counter].load(std::memory_order_relaxed);
+        const size_t bound = ThreadSlot::assigned_bound();
+        for (size_t slot = 0; slot < bound; ++slot) {
+            total += shards_[slot].values[counter].load(std::memory_order_relaxed);
+        }
+        return total;
+    }
+
+private:
+    struct alignas(64) Shard {
+        std::atomic<uint64_t> values[N];
+    };
+
+    std::unique_ptr<Shard[]> shards_; // kMaxSlots per-slot shards, then the shared one
+};
+
+#endif // SHARDED_COUNTERS_HPP
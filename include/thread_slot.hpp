@@ -0,0 +1,39 @@
+#ifndef THREAD_SLOT_HPP
+#define THREAD_SLOT_HPP
+
+#include <cstddef> // For size_t
+
+// Small dense per-thread id ("slot"), the analogue of a DPDK lcore id.
+//
+// Pools index fixed per-slot arrays (thread caches, ...) with it so the owning thread can use
+// them without atomics. A slot is handed out on a thread's first call to current() and is
+// returned when that thread exits, to be reused by the next thread that asks. If more than
+// kMaxSlots threads are alive at once, the extra ones get kNone and take the shared paths,
+// as does code in a thread_local destructor that runs after the slot was returned.
+class ThreadSlot {
+public:
+    static constexpr size_t kMaxSlots = 128;
+    static constexpr size_t kNone = kMaxSlots;
+
+    static size_t current() {
+        size_t slot = cached_slot_;
+        return slot != kUnassigned ? slot : acquire();
+    }
+
+    // One past the highest slot ever handed out. Readers that aggregate per-slot data
+    // (statistics shards, ...) only need to visit [0, assigned_bound()).
+    static size_t assigned_bound();
+
+private:
+    static constexpr size_t kUnassigned = kMaxSlots + 1;
+
+    static size_t acquire(); // Slow path: first call on this thread
+    struct Releaser;         // Returns the slot at thread exit (thread_slot.cpp)
+    static thread_local Releaser releaser_;
+
+    // Defined inline with a constant initializer so other translation units read it
+    // directly rather than through a TLS wrapper call on every current().
+    static inline thread_local size_t cached_slot_ = kUnassigned;
+};
+
+#endif // THREAD_SLOT_HPP
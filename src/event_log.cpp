@@ -0,0 +1,181 @@
+#include "event_log.hpp"
+#include <iostream>
+#include <sstream>
+#include <utility> // For std::move
+
+namespace {
+
+uint64_t steady_now_ns() {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+size_t round_up_pow2(size_t value) {
+    size_t p = 1;
+    while (p < value) {
+        p <<= 1;
+    }
+    return p;
+}
+
+} // namespace
+
+const char* event_type_name(EventRecord::Type type) {
+    switch (type) {
+        case EventRecord::Type::PoolExhausted:  return "pool_exhausted";
+        case EventRecord::Type::NoSuitablePool: return "no_suitable_pool";
+        case EventRecord::Type::LocalExhausted: return "local_node_exhausted";
+        case EventRecord::Type::kCount:         break;
+    }
+    return "unknown";
+}
+
+std::string format_event(const EventRecord& record) {
+    std::ostringstream out;
+    out << "PoolManager: " << event_type_name(record.type)
+        << " (size: " << record.payload_size
+        << ", node: " << record.numa_node
+        << ", count: " << record.count
+        << ", t: " << record.timestamp_ns << " ns)";
+    return out.str();
+}
+
+EventLog::EventLog(size_t capacity, uint32_t max_per_window, std::chrono::milliseconds window)
+: capacity_(round_up_pow2(capacity < 2 ? 2 : capacity)),
+  mask_(capacity_ - 1),
+  max_per_window_(max_per_window),
+  window_ns_(static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(window).count())),
+  cells_(new Cell[capacity_])
+{
+    for (size_t i = 0; i < capacity_; ++i) {
+        cells_[i].sequence.store(i, std::memory_order_relaxed);
+    }
+}
+
+EventLog::~EventLog() {
+    stop_background_drain();
+}
+
+bool EventLog::admit(RateLimit& limit, uint64_t now_ns) {
+    uint64_t start = limit.window_start_ns.load(std::memory_order_relaxed);
+    if (now_ns - start >= window_ns_) {
+        // First event of a new window resets it; losers of the race just count against it.
+        if (limit.window_start_ns.compare_exchange_strong(start, now_ns, std::memory_order_relaxed)) {
+            limit.in_window.store(0, std::memory_order_relaxed);
+        }
+    }
+    // Under a storm the counter is already saturated; skip the RMW so suppressed events
+    // cost a load and one counter bump.
+    if (limit.in_window.load(std::memory_order_relaxed) >= max_per_window_ ||
+        limit.in_window.fetch_add(1, std::memory_order_relaxed) >= max_per_window_) {
+        limit.suppressed.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    return true;
+}
+
+void EventLog::record(EventRecord::Type type, int numa_node, size_t payload_size, size_t count) {
+    const uint64_t now = steady_now_ns();
+    if (!admit(limits_[static_cast<size_t>(type)], now)) {
+        return;
+    }
+
+    size_t pos = enqueue_pos_.load(std::memory_order_relaxed);
+    for (;;) {
+        Cell& cell = cells_[pos & mask_];
+        size_t seq = cell.sequence.load(std::memory_order_acquire);
+        intptr_t diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos);
+        if (diff == 0) {
+            if (enqueue_pos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                cell.record.timestamp_ns = now;
+                cell.record.type = type;
+                cell.record.numa_node = numa_node;
+                cell.record.payload_size = payload_size;
+                cell.record.count = count;
+                cell.sequence.store(pos + 1, std::memory_order_release);
+                recorded_.fetch_add(1, std::memory_order_relaxed);
+                return;
+            }
+        } else if (diff < 0) {
+            dropped_.fetch_add(1, std::memory_order_relaxed); // Ring full: nobody is draining
+            return;
+        } else {
+            pos = enqueue_pos_.load(std::memory_order_relaxed);
+        }
+    }
+}
+
+bool EventLog::try_pop(EventRecord& out) {
+    size_t pos = dequeue_pos_.load(std::memory_order_relaxed);
+    for (;;) {
+        Cell& cell = cells_[pos & mask_];
+        size_t seq = cell.sequence.load(std::memory_order_acquire);
+        intptr_t diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos + 1);
+        if (diff == 0) {
+            if (dequeue_pos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                out = cell.record;
+                cell.sequence.store(pos + capacity_, std::memory_order_release);
+                return true;
+            }
+        } else if (diff < 0) {
+            return false; // Empty
+        } else {
+            pos = dequeue_pos_.load(std::memory_order_relaxed);
+        }
+    }
+}
+
+size_t EventLog::drain(const Sink& sink) {
+    size_t drained = 0;
+    EventRecord record;
+    while (try_pop(record)) {
+        if (sink) {
+            sink(record);
+        }
+        ++drained;
+    }
+    return drained;
+}
+
+void EventLog::start_background_drain(Sink sink, std::chrono::milliseconds interval) {
+    stop_background_drain();
+    if (!sink) {
+        sink = [](const EventRecord& record) { std::cerr << format_event(record) << '\n'; };
+    }
+    {
+        std::lock_guard<std::mutex> lock(drain_mutex_);
+        drain_stop_ = false;
+    }
+    drain_thread_ = std::thread([this, sink = std::move(sink), interval]() {
+        std::unique_lock<std::mutex> lock(drain_mutex_);
+        while (!drain_stop_) {
+            drain_cv_.wait_for(lock, interval, [this]() { return drain_stop_; });
+            lock.unlock();
+            drain(sink);
+            lock.lock();
+        }
+    });
+}
+
+void EventLog::stop_background_drain() {
+    {
+        std::lock_guard<std::mutex> lock(drain_mutex_);
+        drain_stop_ = true;
+    }
+    drain_cv_.notify_all();
+    if (drain_thread_.joinable()) {
+        drain_thread_.join();
+    }
+}
+
+uint64_t EventLog::suppressed_count() const {
+    uint64_t total = 0;
+    for (const RateLimit& limit : limits_) {
+        total += limit.suppressed.load(std::memory_order_relaxed);
+    }
+    return total;
+}
+
+uint64_t EventLog::suppressed_count(EventRecord::Type type) const {
+    return limits_[static_cast<size_t>(type)].suppressed.load(std::memory_order_relaxed);
+}
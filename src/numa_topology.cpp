@@ -0,0 +1,100 @@
+#include "numa_topology.hpp"
+#include <sched.h> // For getcpu (glibc 2.29+, served from the vDSO on x86-64)
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <string>
+
+namespace {
+
+// Parses a sysfs cpulist/nodelist such as "0-3,8,10-11".
+std::vector<int> parse_list(const std::string& text) {
+    std::vector<int> values;
+    std::stringstream ss(text);
+    std::string range;
+    while (std::getline(ss, range, ',')) {
+        if (range.empty() || range == "\n") {
+            continue;
+        }
+        size_t dash = range.find('-');
+        try {
+            int first = std::stoi(range.substr(0, dash));
+            int last = (dash == std::string::npos) ? first : std::stoi(range.substr(dash + 1));
+            for (int v = first; v <= last; ++v) {
+                values.push_back(v);
+            }
+        } catch (const std::exception&) {
+            // Malformed entry; ignore it rather than fail topology discovery.
+        }
+    }
+    return values;
+}
+
+std::vector<int> read_online_nodes() {
+    std::ifstream file("/sys/devices/system/node/online");
+    std::string line;
+    std::vector<int> nodes;
+    if (file && std::getline(file, line)) {
+        nodes = parse_list(line);
+    }
+    if (nodes.empty()) {
+        nodes.push_back(0); // No NUMA sysfs: behave as a single-node machine
+    }
+    std::sort(nodes.begin(), nodes.end());
+    return nodes;
+}
+
+// Row `node` of the SLIT: distance to node i is entry i (indexed by node id, which is
+// dense for the possible-node range the kernel prints).
+std::vector<int> read_distances(int node) {
+    std::ifstream file("/sys/devices/system/node/node" + std::to_string(node) + "/distance");
+    std::vector<int> distances;
+    int d;
+    while (file >> d) {
+        distances.push_back(d);
+    }
+    return distances;
+}
+
+} // namespace
+
+const std::vector<int>& NumaTopology::online_nodes() {
+    static const std::vector<int> nodes = read_online_nodes();
+    return nodes;
+}
+
+bool NumaTopology::is_online(int node) {
+    const std::vector<int>& nodes = online_nodes();
+    return std::binary_search(nodes.begin(), nodes.end(), node);
+}
+
+std::vector<int> NumaTopology::nodes_by_distance(int node) {
+    if (!is_online(node)) {
+        return {};
+    }
+    std::vector<int> order = online_nodes();
+    std::vector<int> distances = read_distances(node);
+    auto distance_to = [&distances, node](int other) {
+        if (other >= 0 && static_cast<size_t>(other) < distances.size()) {
+            return distances[other];
+        }
+        return other == node ? 0 : 1 << 30; // Unknown: self nearest, others last
+    };
+    std::stable_sort(order.begin(), order.end(), [&](int a, int b) {
+        // Self first even if the SLIT were to report a tie with a neighbour.
+        if ((a == node) != (b == node)) {
+            return a == node;
+        }
+        return distance_to(a) < distance_to(b);
+    });
+    return order;
+}
+
+void NumaTopology::refresh_current_node() {
+    unsigned cpu = 0;
+    unsigned node = 0;
+    if (::getcpu(&cpu, &node) == 0) {
+        cached_node_ = static_cast<int>(node);
+    }
+    calls_until_refresh_ = kRefreshInterval;
+}
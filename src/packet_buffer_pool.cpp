@@ -0,0 +1,1082 @@
+#include "packet_buffer_pool.hpp"
+#include "buffer_metadata.hpp"
+#include "thread_slot.hpp"
+#include "numa_topology.hpp" // For NumaTopology::current_node() on the remote-free path
+#include <algorithm> // For std::max, std::min
+#include <chrono>
+#include <cstdint>   // For UINT32_MAX
+#include <new>       // For placement new, std::bad_alloc
+#include <utility>   // For std::move
+#include <stdexcept> // For std::invalid_argument
+
+namespace {
+
+constexpr size_t align_up(size_t value, size_t alignment) {
+    return (value + alignment - 1) & ~(alignment - 1);
+}
+
+// Bulk paths stage indices on the stack in chunks of this many.
+constexpr size_t kBulkChunk = 64;
+
+size_t effective_max_count(size_t initial_count, const PoolGrowthPolicy& growth) {
+    return std::max(initial_count, growth.max_count);
+}
+
+// The PacketBuffer object opens its unit, so its hot first 64 bytes are one cache line;
+// the BufferMetadata follows it, sharing the second line with the buffer's cold fields.
+constexpr size_t kBufferObjOffset = 0;
+constexpr size_t kMetadataOffset = align_up(sizeof(PacketBuffer), alignof(BufferMetadata));
+constexpr size_t kDataAreaOffset = align_up(kMetadataOffset + sizeof(BufferMetadata),
+                                            PacketBufferPool::kCacheLineSize);
+
+// Backstop for a refill request whose notify raced with the worker going to sleep.
+constexpr std::chrono::milliseconds kMaintenancePollInterval(10);
+
+constexpr size_t kDefaultShrinkRegionBytes = size_t(64) << 10;
+
+// Serializes handing out and retiring handle pool ids.
+std::mutex handle_pools_mutex;
+
+} // namespace
+
+PacketBufferPool::PacketBufferPool(size_t buffer_payload_size,
+                                   size_t initial_count,
+                                   int numa_node,
+                                   size_t headroom,
+                                   size_t tailroom,
+                                   size_t per_thread_cache_size,
+                                   MemoryBacking memory_backing,
+                                   const PoolGrowthPolicy& growth,
+                                   const PoolShrinkPolicy& shrink,
+                                   const PoolRemoteFreePolicy& remote_free)
+: buffer_payload_size_(buffer_payload_size),
+  initial_pool_count_(initial_count),
+  numa_node_(numa_node),
+  headroom_size_(headroom),
+  tailroom_size_(tailroom),
+  single_buffer_unit_alloc_size_(0),
+  requested_memory_backing_(memory_backing),
+  free_list_(static_cast<uint32_t>(std::min<size_t>(effective_max_count(initial_count, growth),
+                                                      LockFreeFreeList::kEmpty))),
+  per_thread_cache_size_(per_thread_cache_size),
+  remote_free_batch_(numa_node >= 0 ? std::min(remote_free.batch_size, initial_count / 2) : 0),
+  max_count_(effective_max_count(initial_count, growth)),
+  growth_step_(growth.growth_step ? growth.growth_step : (initial_count ? initial_count : 64)),
+  low_watermark_(growth.low_watermark),
+  shrink_idle_period_(shrink.idle_period),
+  shrink_region_bytes_(shrink.region_bytes ? shrink.region_bytes : kDefaultShrinkRegionBytes),
+  shrink_lazy_free_(shrink.lazy_free)
+{
+    // Indices are 32-bit and LockFreeFreeList::kEmpty is reserved as the sentinel.
+    if (max_count_ >= LockFreeFreeList::kEmpty) {
+        throw std::invalid_argument("PacketBufferPool: buffer count exceeds the 32-bit buffer index space");
+    }
+    // PacketBuffer keeps data-area sizes and offsets in 32 bits.
+    if (headroom > UINT32_MAX || tailroom > UINT32_MAX || buffer_payload_size > UINT32_MAX ||
+        headroom + tailroom + buffer_payload_size > UINT32_MAX) {
+        throw std::invalid_argument("PacketBufferPool: headroom + payload + tailroom must be below 4 GiB");
+    }
+    buffers_.reset(new PacketBuffer*[max_count_ ? max_count_ : 1]);
+    if (shrink_enabled()) {
+        // Every region holds at least one unit, so max_count_ counters always suffice.
+        region_of_.reset(new uint32_t[max_count_ ? max_count_ : 1]);
+        region_free_.reset(new std::atomic<uint32_t>[max_count_ ? max_count_ : 1]);
+        for (size_t i = 0; i < max_count_; ++i) {
+            region_free_[i].store(0, std::memory_order_relaxed);
+        }
+    }
+    if (!initialize_pool()) {
+        throw std::bad_alloc();
+    }
+    initialize_thread_caches();
+    initialize_remote_queues();
+    register_handle_pool_id();
+    if (refill_enabled()) {
+        maintenance_thread_ = std::thread(&PacketBufferPool::maintenance_worker, this);
+    }
+}
+
+PacketBufferPool::~PacketBufferPool() {
+    if (has_handles()) {
+        std::lock_guard<std::mutex> lock(handle_pools_mutex);
+        handle_pools_[handle_pool_id_].store(nullptr, std::memory_order_release);
+    }
+    if (maintenance_thread_.joinable()) {
+        {
+            std::lock_guard<std::mutex> lock(maintenance_mutex_);
+            maintenance_stop_ = true;
+        }
+        maintenance_cv_.notify_all();
+        maintenance_thread_.join();
+    }
+    // Buffers still held by users at this point dangle; the pool owns all the memory.
+    // Parked regions were already destroyed when they were released.
+    if (regions_.empty()) {
+        destroy_units(0, buffer_count_.load(std::memory_order_acquire));
+    } else {
+        for (const Region& region : regions_) {
+            if (!region.released) {
+                destroy_units(region.first_index, region.count);
+            }
+        }
+    }
+    buffer_count_.store(0, std::memory_order_relaxed);
+    pool_memory_block_ = nullptr; // pool_memory_ and growth_chunks_ unmap the slabs
+}
+
+// Lays out every buffer unit back to back in one cache-line aligned block:
+//   [PacketBuffer | BufferMetadata | pad] [headroom | payload | tailroom | pad]
+// The data area of every unit starts on a cache-line boundary and every unit is a whole
+// number of cache lines, so no buffer's packet bytes share a line with another buffer's
+// bookkeeping and a DMA-style write or header parse never straddles one needlessly.
+// Grown chunks use the same layout, so every unit looks alike whichever chunk it is in.
+bool PacketBufferPool::initialize_pool() {
+    const size_t data_area_offset = kDataAreaOffset;
+    const size_t data_area_size = headroom_size_ + buffer_payload_size_ + tailroom_size_;
+    single_buffer_unit_alloc_size_ = data_area_offset + align_up(data_area_size, kCacheLineSize);
+
+    if (initial_pool_count_ == 0) {
+        return true;
+    }
+
+    // Mappings are page aligned, which covers kCacheLineSize. The slab comes back bound
+    // to numa_node_ (when it is a real node) and already faulted in.
+    pool_memory_ = PoolMemory::map(single_buffer_unit_alloc_size_ * initial_pool_count_,
+                                   requested_memory_backing_, numa_node_);
+    pool_memory_block_ = pool_memory_.data();
+    if (!pool_memory_block_) {
+        return false;
+    }
+    mapped_bytes_.store(pool_memory_.size(), std::memory_order_relaxed);
+    construct_units(pool_memory_block_, 0, initial_pool_count_);
+    buffer_count_.store(initial_pool_count_, std::memory_order_release);
+    if (shrink_enabled()) {
+        add_regions(0, 0, initial_pool_count_);
+    }
+    push_free_range(0, initial_pool_count_);
+    return true;
+}
+
+void PacketBufferPool::construct_units(unsigned char* block, size_t first_index, size_t count) {
+    const size_t metadata_offset = kMetadataOffset;
+    const size_t buffer_obj_offset = kBufferObjOffset;
+    const size_t data_area_offset = kDataAreaOffset;
+
+    for (size_t i = 0; i < count; ++i) {
+        unsigned char* unit = block + i * single_buffer_unit_alloc_size_;
+        BufferMetadata* meta = new (unit + metadata_offset) BufferMetadata();
+        PacketBuffer* buffer = new (unit + buffer_obj_offset) PacketBuffer(
+            this,
+            unit,
+            single_buffer_unit_alloc_size_,
+            unit + data_area_offset,
+            buffer_payload_size_,
+            headroom_size_,
+            tailroom_size_,
+            meta,
+            numa_node_
+        );
+        buffer->pool_index_ = static_cast<uint32_t>(first_index + i);
+        buffers_[first_index + i] = buffer;
+    }
+}
+
+void PacketBufferPool::destroy_units(size_t first_index, size_t count) {
+    for (size_t i = first_index; i < first_index + count; ++i) {
+        PacketBuffer* buffer = buffers_[i];
+        BufferMetadata* meta = buffer->metadata_;
+        buffer->~PacketBuffer();
+        if (meta) {
+            meta->~BufferMetadata();
+        }
+    }
+}
+
+// buffers_[index] keeps its address while the unit is parked, so this also works for
+// units whose objects have been destroyed.
+unsigned char* PacketBufferPool::unit_start(size_t index) const {
+    return reinterpret_cast<unsigned char*>(buffers_[index]) - kBufferObjOffset;
+}
+
+// Pushes in chunks, last chunk first, so allocations walk the block front to back.
+void PacketBufferPool::push_free_range(size_t first_index, size_t count) {
+    uint32_t chunk[kBulkChunk];
+    size_t end = first_index + count;
+    while (end > first_index) {
+        size_t m = std::min(end - first_index, kBulkChunk);
+        for (size_t k = 0; k < m; ++k) {
+            chunk[k] = static_cast<uint32_t>(end - m + k);
+        }
+        push_shared(chunk, m);
+        end -= m;
+    }
+}
+
+PoolMemory& PacketBufferPool::chunk_memory(size_t chunk) {
+    return chunk == 0 ? pool_memory_ : growth_chunks_[chunk - 1];
+}
+
+// Regions span at least two release granules, so each one contains at least one whole
+// granule however its units fall relative to page boundaries.
+void PacketBufferPool::add_regions(size_t chunk, size_t first_index, size_t count) {
+    const size_t span = std::max(shrink_region_bytes_, 2 * chunk_memory(chunk).release_granule());
+    const size_t units = std::max<size_t>(1, (span + single_buffer_unit_alloc_size_ - 1) /
+                                                 single_buffer_unit_alloc_size_);
+    for (size_t first = first_index; first < first_index + count; first += units) {
+        Region region;
+        region.first_index = first;
+        region.count = std::min(units, first_index + count - first);
+        region.chunk = chunk;
+        // Set before the units' indices are first pushed, which publishes them.
+        for (size_t i = first; i < first + region.count; ++i) {
+            region_of_[i] = static_cast<uint32_t>(regions_.size());
+        }
+        regions_.push_back(region);
+    }
+}
+
+bool PacketBufferPool::expand_pool(size_t additional_count) {
+    std::lock_guard<std::mutex> lock(chunk_mutex_);
+    const size_t current = buffer_count_.load(std::memory_order_relaxed);
+    const size_t count = std::min(additional_count, max_count_ - current);
+    if (count == 0) {
+        return false;
+    }
+    PoolMemory chunk = PoolMemory::map(single_buffer_unit_alloc_size_ * count,
+                                       requested_memory_backing_, numa_node_);
+    if (!chunk.data()) {
+        return false;
+    }
+    construct_units(chunk.data(), current, count);
+    mapped_bytes_.fetch_add(chunk.size(), std::memory_order_relaxed);
+    growth_chunks_.push_back(std::move(chunk));
+    if (shrink_enabled()) {
+        add_regions(growth_chunks_.size(), current, count);
+    }
+    buffer_count_.store(current + count, std::memory_order_release);
+    push_free_range(current, count);
+    return true;
+}
+
+// A parked region is only revivable once allocators have popped (and dropped) all of its
+// stale indices: pushing an index that is still on the list would corrupt it.
+bool PacketBufferPool::revive_regions(size_t want) {
+    std::lock_guard<std::mutex> lock(chunk_mutex_);
+    size_t revived = 0;
+    for (size_t r = 0; r < regions_.size() && revived < want; ++r) {
+        Region& region = regions_[r];
+        if (!region.released || region_free_[r].load(std::memory_order_acquire) != kRegionParked) {
+            continue;
+        }
+        // Only the header lines are touched here; data pages refault as packets fill them.
+        construct_units(unit_start(region.first_index), region.first_index, region.count);
+        region.released = false;
+        region.free_since = {};
+        released_bytes_.fetch_sub(region.released_bytes, std::memory_order_relaxed);
+        region.released_bytes = 0;
+        released_buffer_count_.fetch_sub(region.count, std::memory_order_relaxed);
+        region_free_[r].store(0, std::memory_order_relaxed);
+        push_free_range(region.first_index, region.count);
+        revived += region.count;
+    }
+    return revived > 0;
+}
+
+// Parks the regions whose buffers have all been on the shared free list at every scan for
+// the idle period. Occupancy comes from the per-region counts, so the list stays in place
+// and allocators keep popping from it throughout. Parking is one CAS on the region's
+// count: an allocator that popped one of its indices first makes the CAS fail, and one
+// that pops an index after it finds the parked bit and drops the index (see claim_popped).
+void PacketBufferPool::shrink_idle_regions() {
+    std::lock_guard<std::mutex> lock(chunk_mutex_);
+
+    size_t on_list = 0;
+    for (size_t r = 0; r < regions_.size(); ++r) {
+        if (!regions_[r].released) {
+            on_list += region_free_[r].load(std::memory_order_relaxed);
+        }
+    }
+
+    const auto now = std::chrono::steady_clock::now();
+    std::vector<Region*> parked;
+    for (size_t r = 0; r < regions_.size(); ++r) {
+        Region& region = regions_[r];
+        if (region.released) {
+            continue;
+        }
+        uint32_t all_free = static_cast<uint32_t>(region.count);
+        if (region_free_[r].load(std::memory_order_relaxed) != all_free) {
+            region.free_since = {};
+            continue;
+        }
+        if (region.free_since == std::chrono::steady_clock::time_point{}) {
+            region.free_since = now;
+            continue;
+        }
+        // Keep a region's worth of buffers above the low watermark so parking never
+        // immediately trips a refill.
+        if (now - region.free_since < shrink_idle_period_ ||
+            on_list < 2 * region.count + low_watermark_) {
+            continue;
+        }
+        // Acquire: the freeing threads' last writes to these buffers happen before the
+        // units are destroyed and their pages released.
+        if (!region_free_[r].compare_exchange_strong(all_free, kRegionParked | all_free,
+                                                     std::memory_order_acq_rel)) {
+            region.free_since = {};
+            continue;
+        }
+        region.released = true;
+        on_list -= region.count;
+        released_buffer_count_.fetch_add(region.count, std::memory_order_relaxed);
+        parked.push_back(&region);
+    }
+
+    for (Region* region : parked) {
+        destroy_units(region->first_index, region->count);
+        region->released_bytes = chunk_memory(region->chunk).release(
+            unit_start(region->first_index), region->count * single_buffer_unit_alloc_size_,
+            shrink_lazy_free_);
+        released_bytes_.fetch_add(region->released_bytes, std::memory_order_relaxed);
+        total_bytes_returned_.fetch_add(region->released_bytes, std::memory_order_relaxed);
+    }
+}
+
+// Counts the indices into their regions before they become poppable, one RMW per run of
+// same-region indices.
+void PacketBufferPool::push_shared(const uint32_t* indices, size_t count) {
+    if (count == 0) {
+        return;
+    }
+    if (shrink_enabled()) {
+        for (size_t i = 0; i < count;) {
+            const uint32_t region = region_of_[indices[i]];
+            size_t run = 1;
+            while (i + run < count && region_of_[indices[i + run]] == region) {
+                ++run;
+            }
+            // Release: orders the caller's writes to the buffers before a parking CAS.
+            region_free_[region].fetch_add(static_cast<uint32_t>(run), std::memory_order_release);
+            i += run;
+        }
+    }
+    if (count == 1) {
+        free_list_.push(indices[0]);
+    } else {
+        free_list_.push_bulk(indices, count);
+    }
+}
+
+// Takes freshly popped indices out of their regions' counts and drops those of regions
+// parked since they were pushed: their units are gone. Compacts the survivors to the front
+// of indices and returns how many there are.
+size_t PacketBufferPool::claim_popped(uint32_t* indices, size_t count) {
+    size_t kept = 0;
+    for (size_t i = 0; i < count;) {
+        const uint32_t region = region_of_[indices[i]];
+        size_t run = 1;
+        while (i + run < count && region_of_[indices[i + run]] == region) {
+            ++run;
+        }
+        const uint32_t before = region_free_[region].fetch_sub(static_cast<uint32_t>(run),
+                                                               std::memory_order_acq_rel);
+        if ((before & kRegionParked) == 0) {
+            std::copy(indices + i, indices + i + run, indices + kept);
+            kept += run;
+        }
+        i += run;
+    }
+    return kept;
+}
+
+uint32_t PacketBufferPool::pop_shared() {
+    for (;;) {
+        uint32_t index = free_list_.pop();
+        if (index == LockFreeFreeList::kEmpty || !shrink_enabled() || claim_popped(&index, 1) == 1) {
+            return index;
+        }
+    }
+}
+
+size_t PacketBufferPool::pop_bulk_shared(uint32_t* out, size_t max_count) {
+    if (!shrink_enabled()) {
+        return free_list_.pop_bulk(out, max_count);
+    }
+    size_t got = 0;
+    while (got < max_count) {
+        size_t popped = free_list_.pop_bulk(out + got, max_count - got);
+        if (popped == 0) {
+            break;
+        }
+        got += claim_popped(out + got, popped);
+    }
+    return got;
+}
+
+// An allocation that came up empty always asks: with thread caches the global free count
+// can stay above the watermark while this thread sees nothing.
+void PacketBufferPool::request_refill_if_low(bool exhausted) {
+    if ((!exhausted && free_estimate() > low_watermark_) ||
+        (buffer_count_.load(std::memory_order_relaxed) >= max_count_ &&
+         released_buffer_count_.load(std::memory_order_relaxed) == 0) ||
+        refill_requested_.load(std::memory_order_relaxed) ||
+        refill_requested_.exchange(true, std::memory_order_relaxed)) {
+        return;
+    }
+    maintenance_cv_.notify_one();
+}
+
+void PacketBufferPool::maintenance_worker() {
+    const auto scan_interval = std::max(std::chrono::milliseconds(1), shrink_idle_period_ / 4);
+    auto next_scan = std::chrono::steady_clock::now() + scan_interval;
+    auto next_sample = std::chrono::steady_clock::now();
+
+    std::unique_lock<std::mutex> lock(maintenance_mutex_);
+    while (!maintenance_stop_) {
+        // Telemetry can be switched on and off while we run, so the period is re-read.
+        const bool sampling = telemetry_enabled_.load(std::memory_order_relaxed);
+        const std::chrono::milliseconds sample_interval(sample_interval_ms_.load(std::memory_order_relaxed));
+        auto wait = kMaintenancePollInterval;
+        if (shrink_enabled()) {
+            wait = std::min(wait, scan_interval);
+        }
+        if (sampling) {
+            wait = std::min(wait, sample_interval);
+        }
+        maintenance_cv_.wait_for(lock, wait, [this]() {
+            return maintenance_stop_ || refill_requested_.load(std::memory_order_relaxed);
+        });
+        if (maintenance_stop_) {
+            break;
+        }
+        lock.unlock();
+        if (refill_requested_.load(std::memory_order_relaxed)) {
+            // Parked memory first: it is already mapped and bound.
+            if (!revive_regions(growth_step_)) {
+                expand_pool(growth_step_);
+            }
+            // Cleared only now, so requests raised while refilling collapse into this one;
+            // if the pool is still low the next allocation asks again.
+            refill_requested_.store(false, std::memory_order_relaxed);
+        }
+        if (shrink_enabled() && std::chrono::steady_clock::now() >= next_scan) {
+            shrink_idle_regions();
+            next_scan = std::chrono::steady_clock::now() + scan_interval;
+        }
+        if (sampling && std::chrono::steady_clock::now() >= next_sample) {
+            sample_occupancy();
+            next_sample = std::chrono::steady_clock::now() + sample_interval;
+        }
+        lock.lock();
+    }
+}
+
+void PacketBufferPool::initialize_thread_caches() {
+    // A cache may hold up to 1.5x its nominal size before spilling, and all of that must fit
+    // in the pool or a single thread could strand every buffer.
+    size_t max_cache_size = initial_pool_count_ * 2 / 3;
+    if (per_thread_cache_size_ > max_cache_size) {
+        per_thread_cache_size_ = max_cache_size;
+    }
+    if (per_thread_cache_size_ == 0) {
+        return;
+    }
+    cache_flush_threshold_ = per_thread_cache_size_ + (per_thread_cache_size_ + 1) / 2;
+
+    // Round each thread's slice up to a full cache line so two threads never share one.
+    const size_t entries_per_line = 64 / sizeof(uint32_t);
+    const size_t stride = align_up(cache_flush_threshold_, entries_per_line);
+    cache_storage_.reset(new uint32_t[stride * ThreadSlot::kMaxSlots]);
+    thread_caches_.reset(new ThreadCache[ThreadSlot::kMaxSlots]);
+    for (size_t slot = 0; slot < ThreadSlot::kMaxSlots; ++slot) {
+        thread_caches_[slot].objs = cache_storage_.get() + slot * stride;
+    }
+}
+
+void PacketBufferPool::register_handle_pool_id() {
+    if (max_count_ > size_t(BufferHandle::kMaxIndex) + 1) {
+        return; // Indices would not fit in a handle
+    }
+    std::lock_guard<std::mutex> lock(handle_pools_mutex);
+    for (uint32_t id = 0; id < BufferHandle::kMaxPools; ++id) {
+        if (!handle_pools_[id].load(std::memory_order_relaxed)) {
+            handle_pool_id_ = id;
+            handle_pools_[id].store(this, std::memory_order_release);
+            return;
+        }
+    }
+}
+
+void PacketBufferPool::initialize_remote_queues() {
+    if (remote_free_batch_ == 0) {
+        return;
+    }
+    const size_t stride = align_up(remote_free_batch_, 64 / sizeof(uint32_t));
+    remote_storage_.reset(new uint32_t[stride * ThreadSlot::kMaxSlots]);
+    remote_queues_.reset(new ThreadCache[ThreadSlot::kMaxSlots]);
+    for (size_t slot = 0; slot < ThreadSlot::kMaxSlots; ++slot) {
+        remote_queues_[slot].objs = remote_storage_.get() + slot * stride;
+    }
+}
+
+PacketBufferPool::ThreadCache* PacketBufferPool::local_cache() {
+    if (!thread_caches_) {
+        return nullptr;
+    }
+    size_t slot = ThreadSlot::current();
+    return slot != ThreadSlot::kNone ? &thread_caches_[slot] : nullptr;
+}
+
+PacketBufferPool::ThreadCache* PacketBufferPool::remote_queue() {
+    if (!remote_queues_ || NumaTopology::current_node() == numa_node_) {
+        return nullptr;
+    }
+    size_t slot = ThreadSlot::current();
+    return slot != ThreadSlot::kNone ? &remote_queues_[slot] : nullptr;
+}
+
+// Statistics are left to the caller so the bulk path can account a whole burst at once.
+PacketBuffer* PacketBufferPool::prepare_allocated(uint32_t index) {
+    PacketBuffer* buffer = buffers_[index];
+    buffer->ref_count_.store(1, std::memory_order_relaxed);
+    if (buffer->metadata_) {
+        buffer->metadata_->set_state(BufferMetadata::BufferState::Allocated);
+    }
+    return buffer;
+}
+
+PacketBuffer* PacketBufferPool::allocate_buffer() {
+    if (!telemetry_enabled_.load(std::memory_order_acquire)) {
+        return allocate_untimed();
+    }
+    const uint64_t start = read_cycle_counter();
+    PacketBuffer* buffer = allocate_untimed();
+    const uint64_t cycles = read_cycle_counter() - start;
+    LatencyShard& shard = latency_shards_[ThreadSlot::current() % kLatencyShards];
+    shard.counts[LatencyHistogram::bucket_index(cycles)].fetch_add(1, std::memory_order_relaxed);
+    if (buffer) {
+        note_in_use(in_use_estimate());
+    }
+    return buffer;
+}
+
+PacketBuffer* PacketBufferPool::allocate_untimed() {
+    if (ThreadCache* cache = local_cache()) {
+        Stat cache_result = kStatCacheHits;
+        if (cache->len == 0) {
+            cache_result = kStatCacheMisses;
+            publish_in_use(*cache);
+            cache->len = static_cast<uint32_t>(pop_bulk_shared(cache->objs, per_thread_cache_size_));
+            if (refill_enabled()) {
+                request_refill_if_low(cache->len == 0); // Only on refills: cache hits stay untouched
+            }
+            if (cache->len == 0) {
+                note_exhausted();
+                return nullptr; // Pool exhausted (as far as this thread can see)
+            }
+        }
+        stats_.add(kStatAllocs, 1);
+        stats_.add(cache_result, 1);
+        ++cache->in_use_delta;
+        return prepare_allocated(cache->objs[--cache->len]);
+    }
+
+    uint32_t index = pop_shared();
+    if (index == LockFreeFreeList::kEmpty) {
+        if (refill_enabled()) {
+            request_refill_if_low(true);
+        }
+        note_exhausted();
+        return nullptr; // Pool exhausted
+    }
+    stats_.add(kStatAllocs, 1);
+    add_in_use(1);
+    if (refill_enabled()) {
+        request_refill_if_low(); // After counting this buffer, so the free count is current
+    }
+    return prepare_allocated(index);
+}
+
+void PacketBufferPool::deallocate_buffer(PacketBuffer* buffer) {
+    if (!buffer || buffer->owning_pool_ != this) {
+        return; // Not ours; refuse rather than corrupt the free list
+    }
+    if (buffer->direct_) {
+        detach_clone(buffer); // Resets the buffer, so before the state is set below
+    }
+    if (buffer->metadata_) {
+        buffer->metadata_->set_state(BufferMetadata::BufferState::Free);
+    }
+    stats_.add(kStatDeallocs, 1);
+    return_indices(&buffer->pool_index_, 1);
+}
+
+// Gives a freed clone back its own data area and drops its reference on the buffer it
+// viewed, which may return that buffer (to this pool or another) as well.
+void PacketBufferPool::detach_clone(PacketBuffer* buffer) {
+    PacketBuffer* direct = buffer->direct_;
+    buffer->direct_ = nullptr;
+    buffer->buffer_start_ = unit_start(buffer->pool_index_) + kDataAreaOffset;
+    buffer->total_allocated_size_ = static_cast<uint32_t>(headroom_size_ + buffer_payload_size_ + tailroom_size_);
+    buffer->headroom_ = static_cast<uint32_t>(headroom_size_);
+    buffer->tailroom_ = static_cast<uint32_t>(tailroom_size_);
+    buffer->reset_for_reuse();
+    direct->release();
+}
+
+void PacketBufferPool::return_indices(const uint32_t* indices, size_t count) {
+    // A foreign thread stages its frees and sends them home a batch at a time; checked
+    // before the thread cache so remote buffers do not accumulate in this thread's cache.
+    if (ThreadCache* queue = remote_queue()) {
+        stats_.add(kStatRemoteFrees, count);
+        queue->in_use_delta -= static_cast<int64_t>(count);
+        while (count > 0) {
+            size_t take = std::min(remote_free_batch_ - queue->len, count);
+            std::copy(indices, indices + take, queue->objs + queue->len);
+            queue->len += static_cast<uint32_t>(take);
+            indices += take;
+            count -= take;
+            if (queue->len == remote_free_batch_) {
+                push_shared(queue->objs, queue->len);
+                queue->len = 0;
+                publish_in_use(*queue);
+            }
+        }
+        return;
+    }
+    if (ThreadCache* cache = local_cache()) {
+        cache->in_use_delta -= static_cast<int64_t>(count);
+        while (count > 0) {
+            size_t room = cache_flush_threshold_ - cache->len;
+            size_t take = std::min(room, count);
+            std::copy(indices, indices + take, cache->objs + cache->len);
+            cache->len += static_cast<uint32_t>(take);
+            indices += take;
+            count -= take;
+            if (cache->len >= cache_flush_threshold_) {
+                // Spill everything above the nominal size back in one CAS.
+                push_shared(cache->objs + per_thread_cache_size_,
+                            cache->len - per_thread_cache_size_);
+                cache->len = static_cast<uint32_t>(per_thread_cache_size_);
+                publish_in_use(*cache);
+            }
+        }
+        return;
+    }
+    add_in_use(-static_cast<int64_t>(count));
+    push_shared(indices, count);
+}
+
+bool PacketBufferPool::allocate_bulk(PacketBuffer** out, size_t n) {
+    if (n == 0) {
+        return true;
+    }
+
+    ThreadCache* cache = local_cache();
+    if (cache && n <= cache_flush_threshold_) {
+        Stat cache_result = kStatCacheHits;
+        if (cache->len < n) {
+            cache_result = kStatCacheMisses;
+            publish_in_use(*cache);
+            // Top up to whichever is larger of the burst and the nominal cache size.
+            size_t target = std::max(n, per_thread_cache_size_);
+            cache->len += static_cast<uint32_t>(
+                pop_bulk_shared(cache->objs + cache->len, target - cache->len));
+            if (refill_enabled()) {
+                request_refill_if_low(cache->len < n);
+            }
+            if (cache->len < n) {
+                note_exhausted();
+                return false; // Whatever we did get stays cached for the next call
+            }
+        }
+        for (size_t i = 0; i < n; ++i) {
+            out[i] = prepare_allocated(cache->objs[--cache->len]);
+        }
+        stats_.add(kStatAllocs, n);
+        stats_.add(cache_result, n);
+        cache->in_use_delta += static_cast<int64_t>(n);
+        if (telemetry_enabled_.load(std::memory_order_relaxed)) {
+            note_in_use(in_use_estimate());
+        }
+        return true;
+    }
+
+    // Burst larger than the cache: drain the cache and take the rest from the shared list
+    // in chunks, rolling the shared part back if the pool runs dry midway.
+    const size_t from_cache = cache ? std::min<size_t>(cache->len, n) : 0;
+    const size_t shared_n = n - from_cache;
+    uint32_t chunk[kBulkChunk];
+    size_t done = 0;
+    while (done < shared_n) {
+        size_t want = std::min(shared_n - done, kBulkChunk);
+        size_t got = pop_bulk_shared(chunk, want);
+        for (size_t i = 0; i < got; ++i) {
+            out[done + i] = buffers_[chunk[i]];
+        }
+        done += got;
+        if (got < want) {
+            for (size_t i = 0; i < done; i += kBulkChunk) {
+                size_t m = std::min(done - i, kBulkChunk);
+                for (size_t k = 0; k < m; ++k) {
+                    chunk[k] = out[i + k]->pool_index_;
+                }
+                push_shared(chunk, m);
+            }
+            if (refill_enabled()) {
+                request_refill_if_low(true);
+            }
+            note_exhausted();
+            return false;
+        }
+    }
+    for (size_t i = 0; i < from_cache; ++i) {
+        out[shared_n + i] = buffers_[cache->objs[--cache->len]];
+    }
+    for (size_t i = 0; i < n; ++i) {
+        prepare_allocated(out[i]->pool_index_);
+    }
+    stats_.add(kStatAllocs, n);
+    add_in_use(static_cast<int64_t>(n));
+    if (cache) {
+        stats_.add(kStatCacheHits, from_cache);
+        stats_.add(kStatCacheMisses, shared_n);
+    }
+    if (refill_enabled()) {
+        request_refill_if_low();
+    }
+    if (telemetry_enabled_.load(std::memory_order_relaxed)) {
+        note_in_use(in_use_estimate());
+    }
+    return true;
+}
+
+void PacketBufferPool::free_bulk(PacketBuffer* const* bufs, size_t n) {
+    uint32_t chunk[kBulkChunk];
+    size_t pending = 0;
+    for (size_t i = 0; i < n; ++i) {
+        PacketBuffer* buffer = bufs[i];
+        if (!buffer) {
+            continue;
+        }
+        if (buffer->owning_pool_ != this) {
+            buffer->release(); // Someone else's buffer: take the normal route home
+            continue;
+        }
+        // Same sole-owner shortcut as PacketBuffer::release().
+        if (buffer->ref_count_.load(std::memory_order_acquire) == 1) {
+            buffer->ref_count_.store(0, std::memory_order_relaxed);
+        } else if (buffer->ref_count_.fetch_sub(1, std::memory_order_acq_rel) != 1) {
+            continue; // Still referenced elsewhere
+        }
+        if (buffer->direct_) {
+            detach_clone(buffer); // Includes the reset
+        } else {
+            buffer->reset_for_reuse();
+        }
+        if (buffer->metadata_) {
+            buffer->metadata_->set_state(BufferMetadata::BufferState::Free);
+        }
+        chunk[pending++] = buffer->pool_index_;
+        if (pending == kBulkChunk) {
+            stats_.add(kStatDeallocs, pending);
+            return_indices(chunk, pending);
+            pending = 0;
+        }
+    }
+    if (pending > 0) {
+        stats_.add(kStatDeallocs, pending);
+        return_indices(chunk, pending);
+    }
+}
+
+void PacketBufferPool::flush_thread_cache() {
+    if (ThreadCache* cache = local_cache()) {
+        push_shared(cache->objs, cache->len);
+        cache->len = 0;
+        publish_in_use(*cache);
+    }
+    if (remote_queues_) {
+        // By slot rather than remote_queue(): the thread may have migrated home since staging.
+        size_t slot = ThreadSlot::current();
+        if (slot != ThreadSlot::kNone) {
+            ThreadCache& queue = remote_queues_[slot];
+            push_shared(queue.objs, queue.len);
+            queue.len = 0;
+            publish_in_use(queue);
+        }
+    }
+}
+
+size_t PacketBufferPool::get_buffer_payload_size() const {
+    return buffer_payload_size_;
+}
+
+size_t PacketBufferPool::get_initial_pool_count() const {
+    return initial_pool_count_;
+}
+
+size_t PacketBufferPool::get_free_count() const {
+    // Derived from the sharded statistics rather than kept as a separate shared counter,
+    // so the alloc/free paths write no shared line for it. Approximate under concurrency.
+    size_t in_use = get_in_use_count();
+    size_t total = buffer_count_.load(std::memory_order_relaxed) -
+                   released_buffer_count_.load(std::memory_order_relaxed);
+    return in_use >= total ? 0 : total - in_use;
+}
+
+size_t PacketBufferPool::get_total_count() const {
+    return buffer_count_.load(std::memory_order_relaxed);
+}
+
+size_t PacketBufferPool::get_max_count() const {
+    return max_count_;
+}
+
+int PacketBufferPool::get_numa_node() const {
+    return numa_node_;
+}
+
+size_t PacketBufferPool::get_headroom_size() const {
+    return headroom_size_;
+}
+
+size_t PacketBufferPool::get_tailroom_size() const {
+    return tailroom_size_;
+}
+
+size_t PacketBufferPool::get_per_thread_cache_size() const {
+    return per_thread_cache_size_;
+}
+
+size_t PacketBufferPool::get_remote_free_batch_size() const {
+    return remote_free_batch_;
+}
+
+MemoryBacking PacketBufferPool::get_memory_backing() const {
+    return pool_memory_.backing();
+}
+
+size_t PacketBufferPool::get_memory_footprint() const {
+    return mapped_bytes_.load(std::memory_order_relaxed);
+}
+
+bool PacketBufferPool::is_numa_bound() const {
+    return pool_memory_.bound_node() >= 0;
+}
+
+std::vector<int> PacketBufferPool::get_page_numa_nodes() const {
+    std::lock_guard<std::mutex> lock(chunk_mutex_);
+    std::vector<int> nodes = pool_memory_.page_nodes();
+    for (const PoolMemory& chunk : growth_chunks_) {
+        std::vector<int> chunk_nodes = chunk.page_nodes();
+        nodes.insert(nodes.end(), chunk_nodes.begin(), chunk_nodes.end());
+    }
+    return nodes;
+}
+
+size_t PacketBufferPool::get_alloc_count() const {
+    return stats_.sum(kStatAllocs);
+}
+
+size_t PacketBufferPool::get_dealloc_count() const {
+    return stats_.sum(kStatDeallocs);
+}
+
+size_t PacketBufferPool::get_in_use_count() const {
+    // Frees first: a buffer freed between the two reads then shows as still in use rather
+    // than driving the difference negative.
+    const uint64_t deallocs = stats_.sum(kStatDeallocs);
+    const uint64_t allocs = stats_.sum(kStatAllocs);
+    return allocs >= deallocs ? static_cast<size_t>(allocs - deallocs) : 0;
+}
+
+size_t PacketBufferPool::get_high_water_mark() const {
+    return std::max(high_water_mark_.load(std::memory_order_relaxed), get_in_use_count());
+}
+
+size_t PacketBufferPool::get_alloc_failure_count() const {
+    return stats_.sum(kStatAllocFailures);
+}
+
+size_t PacketBufferPool::get_remote_free_count() const {
+    return stats_.sum(kStatRemoteFrees);
+}
+
+PoolStatistics PacketBufferPool::get_statistics() const {
+    PoolStatistics stats;
+    stats.numa_node = numa_node_;
+    stats.payload_size = buffer_payload_size_;
+    stats.headroom = headroom_size_;
+    stats.tailroom = tailroom_size_;
+    stats.memory_backing = pool_memory_.backing();
+    stats.numa_bound = is_numa_bound();
+    stats.memory_footprint = get_memory_footprint();
+    stats.released_bytes = get_released_bytes();
+    stats.total_bytes_returned = get_total_bytes_returned();
+    stats.initial_count = initial_pool_count_;
+    stats.total_count = get_total_count();
+    stats.max_count = max_count_;
+    stats.free_count = get_free_count();
+    stats.in_use_count = get_in_use_count();
+    stats.high_water_mark = std::max(high_water_mark_.load(std::memory_order_relaxed), stats.in_use_count);
+    stats.alloc_count = stats_.sum(kStatAllocs);
+    stats.free_count_total = stats_.sum(kStatDeallocs);
+    stats.alloc_failures = stats_.sum(kStatAllocFailures);
+    stats.cache_hits = stats_.sum(kStatCacheHits);
+    stats.cache_misses = stats_.sum(kStatCacheMisses);
+    stats.remote_frees = stats_.sum(kStatRemoteFrees);
+    const uint64_t lookups = stats.cache_hits + stats.cache_misses;
+    stats.cache_hit_rate = lookups ? static_cast<double>(stats.cache_hits) / static_cast<double>(lookups) : 0.0;
+    stats.utilization = stats.max_count ? static_cast<double>(stats.in_use_count) / static_cast<double>(stats.max_count) : 0.0;
+    return stats;
+}
+
+void PacketBufferPool::note_exhausted() {
+    stats_.add(kStatAllocFailures, 1);
+    note_in_use(tracks_in_use() ? in_use_estimate() : get_in_use_count());
+}
+
+void PacketBufferPool::add_in_use(int64_t delta) {
+    if (!tracks_in_use()) {
+        return;
+    }
+    const int64_t in_use = in_use_estimate_.fetch_add(delta, std::memory_order_relaxed) + delta;
+    if (delta > 0 && in_use > 0) {
+        raise_high_water_mark(static_cast<size_t>(in_use));
+    }
+}
+
+void PacketBufferPool::publish_in_use(ThreadCache& cache) {
+    if (cache.in_use_delta != 0) {
+        add_in_use(cache.in_use_delta);
+        cache.in_use_delta = 0;
+    }
+}
+
+size_t PacketBufferPool::in_use_estimate() const {
+    // Deltas from different threads land in any order, so the sum may dip below zero.
+    const int64_t in_use = in_use_estimate_.load(std::memory_order_relaxed);
+    return in_use > 0 ? static_cast<size_t>(in_use) : 0;
+}
+
+size_t PacketBufferPool::free_estimate() const {
+    const size_t in_use = in_use_estimate();
+    const size_t total = buffer_count_.load(std::memory_order_relaxed) -
+                         released_buffer_count_.load(std::memory_order_relaxed);
+    return in_use >= total ? 0 : total - in_use;
+}
+
+void PacketBufferPool::note_in_use(size_t in_use) {
+    size_t seen = interval_high_water_.load(std::memory_order_relaxed);
+    while (in_use > seen &&
+           !interval_high_water_.compare_exchange_weak(seen, in_use, std::memory_order_relaxed)) {
+    }
+    raise_high_water_mark(in_use);
+}
+
+void PacketBufferPool::raise_high_water_mark(size_t in_use) {
+    // Plain load first: once the peak is established the CAS is almost never reached.
+    size_t seen = high_water_mark_.load(std::memory_order_relaxed);
+    while (in_use > seen &&
+           !high_water_mark_.compare_exchange_weak(seen, in_use, std::memory_order_relaxed)) {
+    }
+}
+
+void PacketBufferPool::enable_telemetry(const PoolTelemetryConfig& config) {
+    std::lock_guard<std::mutex> lock(telemetry_mutex_);
+    if (!latency_shards_) {
+        latency_shards_.reset(new LatencyShard[kLatencyShards]);
+        for (size_t shard = 0; shard < kLatencyShards; ++shard) {
+            for (std::atomic<uint64_t>& count : latency_shards_[shard].counts) {
+                count.store(0, std::memory_order_relaxed);
+            }
+        }
+    }
+    const size_t history_length = std::max<size_t>(1, config.history_length);
+    if (occupancy_ring_.size() != history_length) {
+        occupancy_ring_.assign(history_length, OccupancySample());
+        occupancy_next_ = 0;
+        occupancy_count_ = 0;
+    }
+    sample_interval_ms_.store(std::max<int64_t>(1, config.sample_interval.count()), std::memory_order_relaxed);
+    if (!refill_enabled()) {
+        // The estimate was not kept up while telemetry was off; start it from the exact count.
+        in_use_estimate_.store(static_cast<int64_t>(get_in_use_count()), std::memory_order_relaxed);
+    }
+    note_in_use(get_in_use_count());
+    interval_high_water_.store(get_in_use_count(), std::memory_order_relaxed);
+    telemetry_enabled_.store(true, std::memory_order_release); // Publishes latency_shards_
+
+    if (!maintenance_thread_.joinable()) {
+        maintenance_thread_ = std::thread(&PacketBufferPool::maintenance_worker, this);
+    }
+}
+
+void PacketBufferPool::disable_telemetry() {
+    telemetry_enabled_.store(false, std::memory_order_relaxed);
+}
+
+bool PacketBufferPool::is_telemetry_enabled() const {
+    return telemetry_enabled_.load(std::memory_order_relaxed);
+}
+
+void PacketBufferPool::sample_occupancy() {
+    OccupancySample sample;
+    sample.timestamp_ns = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+    sample.in_use = get_in_use_count();
+    note_in_use(sample.in_use);
+    // The next interval starts from the current occupancy.
+    sample.interval_high_water = interval_high_water_.exchange(sample.in_use, std::memory_order_relaxed);
+    sample.total = buffer_count_.load(std::memory_order_relaxed) -
+                   released_buffer_count_.load(std::memory_order_relaxed);
+
+    std::lock_guard<std::mutex> lock(telemetry_mutex_);
+    if (occupancy_ring_.empty()) {
+        return;
+    }
+    occupancy_ring_[occupancy_next_] = sample;
+    occupancy_next_ = (occupancy_next_ + 1) % occupancy_ring_.size();
+    occupancy_count_ = std::min(occupancy_count_ + 1, occupancy_ring_.size());
+}
+
+std::vector<OccupancySample> PacketBufferPool::get_occupancy_history() const {
+    std::lock_guard<std::mutex> lock(telemetry_mutex_);
+    std::vector<OccupancySample> history;
+    history.reserve(occupancy_count_);
+    const size_t size = occupancy_ring_.size();
+    for (size_t i = 0; i < occupancy_count_; ++i) {
+        history.push_back(occupancy_ring_[(occupancy_next_ + size - occupancy_count_ + i) % size]);
+    }
+    return history;
+}
+
+LatencyHistogram PacketBufferPool::get_allocation_latency() const {
+    LatencyHistogram histogram;
+    std::lock_guard<std::mutex> lock(telemetry_mutex_);
+    if (!latency_shards_) {
+        return histogram;
+    }
+    for (size_t shard = 0; shard < kLatencyShards; ++shard) {
+        for (size_t bucket = 0; bucket < LatencyHistogram::kBucketCount; ++bucket) {
+            uint64_t count = latency_shards_[shard].counts[bucket].load(std::memory_order_relaxed);
+            if (count) {
+                histogram.add(bucket, count);
+            }
+        }
+    }
+    return histogram;
+}
+
+size_t PacketBufferPool::get_released_buffer_count() const {
+    return released_buffer_count_.load(std::memory_order_relaxed);
+}
+
+size_t PacketBufferPool::get_released_bytes() const {
+    return released_bytes_.load(std::memory_order_relaxed);
+}
+
+size_t PacketBufferPool::get_total_bytes_returned() const {
+    return total_bytes_returned_.load(std::memory_order_relaxed);
+}
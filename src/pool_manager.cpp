@@ -1,6 +1,97 @@
 #include "pool_manager.hpp"
 #include "packet_buffer_pool.hpp" // For PacketBufferPool and its methods
-#include <iostream> // For print_stats and error logging
+#include "numa_topology.hpp"     // For kCurrentNode resolution and distance ordering
+#include <algorithm>
+#include <stdexcept> // For std::invalid_argument
+#include <utility> // For std::pair
+#include <iostream> // For print_stats and configuration messages (never on the allocation path)
+
+// Immutable snapshot of "which pool serves (size, node)", built by
+// publish_size_class_table() and read without locks on every allocation.
+struct PoolManager::SizeClassTable {
+    static constexpr size_t kGranuleShift = 6; // 64-byte size buckets
+
+    struct Entry {
+        size_t payload_size;
+        PacketBufferPool* pool;
+    };
+
+    struct NodeClasses {
+        std::vector<Entry> pools;           // Ascending payload size
+        // bucket_first[b] = first pool able to hold the smallest size in bucket b, so the
+        // scan below starts at (or one step before) the answer.
+        std::vector<uint32_t> bucket_first;
+
+        static size_t bucket_of(size_t size) {
+            return (size + (size_t(1) << kGranuleShift) - 1) >> kGranuleShift;
+        }
+
+        PacketBufferPool* find(size_t size) const {
+            size_t bucket = bucket_of(size);
+            if (bucket >= bucket_first.size()) {
+                return nullptr; // Larger than this node's largest pool
+            }
+            for (size_t i = bucket_first[bucket]; i < pools.size(); ++i) {
+                if (pools[i].payload_size >= size) {
+                    return pools[i].pool;
+                }
+            }
+            return nullptr;
+        }
+    };
+
+    std::vector<NodeClasses> nodes;             // Indexed by node + 1; slot 0 is the global (-1) node
+    std::vector<std::vector<int>> local_orders; // Indexed by node: kCurrentNode fallback order
+
+    const NodeClasses* node_classes(int node) const {
+        if (node < -1 || static_cast<size_t>(node + 1) >= nodes.size()) {
+            return nullptr;
+        }
+        return &nodes[static_cast<size_t>(node + 1)];
+    }
+
+    // Same policy as the old map walk: the node's smallest fitting pool, else the global one.
+    PacketBufferPool* find(size_t size, int node) const {
+        if (const NodeClasses* classes = node_classes(node)) {
+            if (PacketBufferPool* pool = classes->find(size)) {
+                return pool;
+            }
+        }
+        if (node != -1 && !nodes.empty()) {
+            return nodes[0].find(size);
+        }
+        return nullptr;
+    }
+
+    // Calls try_pool on each candidate for a kCurrentNode allocation, best first, until it
+    // returns true. Returns whether any candidate accepted.
+    template <typename TryPool>
+    bool for_each_local_candidate(size_t size, int local_node, TryPool try_pool) const {
+        const std::vector<int>* order = nullptr;
+        if (local_node >= 0 && static_cast<size_t>(local_node) < local_orders.size()) {
+            order = &local_orders[static_cast<size_t>(local_node)];
+        }
+        if (order && !order->empty()) {
+            for (int node : *order) {
+                if (node == -1) {
+                    continue; // Global pools go last regardless
+                }
+                const NodeClasses* classes = node_classes(node);
+                PacketBufferPool* pool = classes ? classes->find(size) : nullptr;
+                if (pool && try_pool(pool)) {
+                    return true;
+                }
+            }
+        } else if (const NodeClasses* classes = node_classes(local_node)) {
+            PacketBufferPool* pool = classes->find(size);
+            if (pool && try_pool(pool)) {
+                return true;
+            }
+        }
+        PacketBufferPool* global = nodes.empty() ? nullptr : nodes[0].find(size);
+        return global && try_pool(global);
+    }
+};
 
 PoolManager& PoolManager::instance() {
     static PoolManager inst; // Meyers singleton
@@ -8,8 +99,9 @@ PoolManager& PoolManager::instance() {
 }
 
 PoolManager::PoolManager() {
-    // Constructor can be empty or initialize NUMA detection if planned.
-    // For now, it's empty. The map is default-constructed.
+    // Publish an empty table so readers never see a null pointer.
+    std::lock_guard<std::mutex> lock(manager_mutex_);
+    publish_size_class_table();
 }
 
 PoolManager::~PoolManager() {
@@ -17,11 +109,18 @@ PoolManager::~PoolManager() {
     // when numa_pools_ is cleared or PoolManager is destroyed.
     // Explicitly clearing can be done for orderliness or if specific cleanup
     // order beyond unique_ptr's destruction is needed (not the case here).
+    clear_statistics_callback(); // The sampler reads the pools
     std::lock_guard<std::mutex> lock(manager_mutex_);
+    delete size_class_table_.exchange(nullptr);
     numa_pools_.clear();
 }
 
 bool PoolManager::configure_pools_for_numa_node(int numa_node, const std::vector<PoolConfig>& configs) {
+    if (numa_node < -1) {
+        // kCurrentNode and other negative values name no node: a pool under them could
+        // never be reached by a lookup.
+        throw std::invalid_argument("PoolManager: numa_node must be -1 (global) or a node id");
+    }
     std::lock_guard<std::mutex> lock(manager_mutex_);
 
     auto& pools_for_specific_numa = numa_pools_[numa_node]; // Creates entry if numa_node not present
@@ -39,7 +138,12 @@ bool PoolManager::configure_pools_for_numa_node(int numa_node, const std::vector
                 config.initial_count,
                 numa_node,
                 config.headroom,
-                config.tailroom
+                config.tailroom,
+                config.per_thread_cache_size,
+                config.memory_backing,
+                config.growth,
+                config.shrink,
+                config.remote_free
             );
             pools_for_specific_numa[config.buffer_size] = std::move(new_pool);
             std::cout << "PoolManager: Configured pool for payload size " << config.buffer_size
@@ -47,13 +151,16 @@ bool PoolManager::configure_pools_for_numa_node(int numa_node, const std::vector
         } catch (const std::bad_alloc& e) {
             std::cerr << "PoolManager: Failed to allocate memory for PacketBufferPool (size: " 
                       << config.buffer_size << ", node: " << numa_node << "). Exception: " << e.what() << std::endl;
+            publish_size_class_table(); // Pools created before the failure stay usable
             return false; // Stop configuration on first failure
         } catch (const std::exception& e) {
             std::cerr << "PoolManager: Failed to create PacketBufferPool (size: " 
                       << config.buffer_size << ", node: " << numa_node << "). Exception: " << e.what() << std::endl;
+            publish_size_class_table();
             return false; // Stop configuration on first failure
         }
     }
+    publish_size_class_table();
     return true;
 }
 
@@ -61,51 +168,98 @@ bool PoolManager::add_pool(int numa_node, const PoolConfig& config) {
     return configure_pools_for_numa_node(numa_node, {config});
 }
 
-// Private helper, assumes manager_mutex_ is held by caller if necessary.
-PacketBufferPool* PoolManager::find_pool(size_t desired_payload_size, int numa_node) const {
-    // Try specified NUMA node first
-    auto it_numa_map = numa_pools_.find(numa_node);
-    if (it_numa_map != numa_pools_.end()) {
-        const auto& size_to_pool_map = it_numa_map->second;
-        // Find the smallest pool that is >= desired_payload_size
-        auto it_pool = size_to_pool_map.lower_bound(desired_payload_size);
-        if (it_pool != size_to_pool_map.end()) {
-            return it_pool->second.get(); // Return raw pointer to the pool
-        }
+void PoolManager::set_numa_fallback_order(int node, const std::vector<int>& order) {
+    std::lock_guard<std::mutex> lock(manager_mutex_);
+    if (order.empty()) {
+        numa_fallback_order_.erase(node); // Back to the distance-based default
+    } else {
+        numa_fallback_order_[node] = order;
     }
+    publish_size_class_table();
+}
+
+// Private helper, assumes manager_mutex_ is held by caller.
+void PoolManager::publish_size_class_table() {
+    auto table = std::make_unique<SizeClassTable>();
 
-    // If not found in specific NUMA node and a specific node was requested, try fallback to global pool (-1)
-    if (numa_node != -1) { 
-        it_numa_map = numa_pools_.find(-1); // Try global pool
-        if (it_numa_map != numa_pools_.end()) {
-            const auto& size_to_pool_map = it_numa_map->second;
-            auto it_pool = size_to_pool_map.lower_bound(desired_payload_size);
-            if (it_pool != size_to_pool_map.end()) {
-                return it_pool->second.get();
+    int max_node = -1;
+    for (const auto& numa_entry : numa_pools_) {
+        max_node = std::max(max_node, numa_entry.first);
+    }
+    table->nodes.resize(static_cast<size_t>(max_node + 2));
+    for (const auto& numa_entry : numa_pools_) {
+        if (numa_entry.first < -1) {
+            continue; // Not addressable by allocate()
+        }
+        SizeClassTable::NodeClasses& classes = table->nodes[static_cast<size_t>(numa_entry.first + 1)];
+        for (const auto& size_entry : numa_entry.second) { // std::map: already ascending
+            classes.pools.push_back({size_entry.first, size_entry.second.get()});
+        }
+        if (classes.pools.empty()) {
+            continue;
+        }
+        size_t max_bucket = SizeClassTable::NodeClasses::bucket_of(classes.pools.back().payload_size);
+        classes.bucket_first.resize(max_bucket + 1);
+        uint32_t first = 0;
+        for (size_t bucket = 0; bucket <= max_bucket; ++bucket) {
+            size_t smallest_in_bucket = bucket == 0 ? 0 : ((bucket - 1) << SizeClassTable::kGranuleShift) + 1;
+            while (first < classes.pools.size() && classes.pools[first].payload_size < smallest_in_bucket) {
+                ++first;
             }
+            classes.bucket_first[bucket] = first;
         }
     }
-    
-    return nullptr; // No suitable pool found
+
+    // kCurrentNode orders for every node a thread could be running on or pools live on.
+    int max_local = max_node;
+    for (int node : NumaTopology::online_nodes()) {
+        max_local = std::max(max_local, node);
+    }
+    for (const auto& order_entry : numa_fallback_order_) {
+        max_local = std::max(max_local, order_entry.first);
+    }
+    table->local_orders.resize(static_cast<size_t>(max_local + 1));
+    for (int node = 0; node <= max_local; ++node) {
+        auto it_override = numa_fallback_order_.find(node);
+        table->local_orders[static_cast<size_t>(node)] = (it_override != numa_fallback_order_.end())
+            ? it_override->second
+            : NumaTopology::nodes_by_distance(node); // Empty for offline nodes: just try the node itself
+    }
+
+    const SizeClassTable* previous = size_class_table_.exchange(table.release(), std::memory_order_seq_cst);
+    if (previous) {
+        // Readers that loaded `previous` before the swap may still be using it.
+        rcu_.synchronize();
+        delete previous;
+    }
 }
 
 PacketBuffer* PoolManager::allocate(size_t desired_payload_size, int numa_node) {
-    PacketBufferPool* pool = nullptr;
-    { // Scope for lock guard
-        std::lock_guard<std::mutex> lock(manager_mutex_);
-        pool = find_pool(desired_payload_size, numa_node);
-    } // Mutex unlocked here
+    RcuDomain::ReadGuard guard(rcu_); // Keeps the table alive; never blocks
+    const SizeClassTable* table = size_class_table_.load(std::memory_order_acquire);
+
+    if (numa_node == kCurrentNode) {
+        const int local_node = NumaTopology::current_node();
+        PacketBuffer* buffer = nullptr;
+        table->for_each_local_candidate(desired_payload_size, local_node, [&buffer](PacketBufferPool* pool) {
+            buffer = pool->allocate_buffer();
+            return buffer != nullptr;
+        });
+        if (!buffer) {
+            event_log_.record(EventRecord::Type::LocalExhausted, local_node, desired_payload_size);
+        }
+        return buffer;
+    }
 
+    PacketBufferPool* pool = table->find(desired_payload_size, numa_node);
     if (pool) {
         PacketBuffer* buffer = pool->allocate_buffer();
         if (!buffer) {
-             std::cerr << "PoolManager: Pool found but failed to allocate buffer (size: " << desired_payload_size 
-                       << ", node: " << numa_node << "). Pool might be empty." << std::endl;
+            event_log_.record(EventRecord::Type::PoolExhausted, numa_node, desired_payload_size);
         }
         return buffer;
     } else {
-        std::cerr << "PoolManager: No suitable pool found for payload size " << desired_payload_size 
-                  << " on NUMA node " << numa_node << "." << std::endl;
+        event_log_.record(EventRecord::Type::NoSuitablePool, numa_node, desired_payload_size);
         // FR-001: Could attempt to create a pool dynamically here if allowed by policy.
     }
     return nullptr;
@@ -127,40 +281,201 @@ void PoolManager::deallocate(PacketBuffer* buffer) {
     // }
     // The safest is to rely on the buffer's own release mechanism.
     // If ref_count is not yet zero, this will just decrement. If it becomes zero, it will deallocate.
-    std::cout << "PoolManager: Deallocating buffer via its release() method." << std::endl;
     buffer->release(); 
 }
 
+bool PoolManager::allocate_bulk(PacketBuffer** out, size_t n, size_t desired_payload_size, int numa_node) {
+    RcuDomain::ReadGuard guard(rcu_); // Keeps the table alive; never blocks
+    const SizeClassTable* table = size_class_table_.load(std::memory_order_acquire);
+
+    if (numa_node == kCurrentNode) {
+        const int local_node = NumaTopology::current_node();
+        bool ok = table->for_each_local_candidate(desired_payload_size, local_node, [out, n](PacketBufferPool* pool) {
+            return pool->allocate_bulk(out, n);
+        });
+        if (!ok) {
+            event_log_.record(EventRecord::Type::LocalExhausted, local_node, desired_payload_size, n);
+        }
+        return ok;
+    }
+
+    PacketBufferPool* pool = table->find(desired_payload_size, numa_node);
+    if (!pool) {
+        event_log_.record(EventRecord::Type::NoSuitablePool, numa_node, desired_payload_size, n);
+        return false;
+    }
+    if (!pool->allocate_bulk(out, n)) {
+        event_log_.record(EventRecord::Type::PoolExhausted, numa_node, desired_payload_size, n);
+        return false;
+    }
+    return true;
+}
+
+void PoolManager::free_bulk(PacketBuffer* const* bufs, size_t n) {
+    // Hand each run of consecutive same-pool buffers to its pool in one call.
+    size_t run_start = 0;
+    while (run_start < n) {
+        if (!bufs[run_start]) {
+            ++run_start;
+            continue;
+        }
+        PacketBufferPool* pool = bufs[run_start]->get_owning_pool();
+        size_t run_end = run_start + 1;
+        while (run_end < n && bufs[run_end] && bufs[run_end]->get_owning_pool() == pool) {
+            ++run_end;
+        }
+        if (pool) {
+            pool->free_bulk(bufs + run_start, run_end - run_start);
+        } else {
+            for (size_t i = run_start; i < run_end; ++i) {
+                bufs[i]->release(); // Orphaned buffers: keep release()'s behaviour
+            }
+        }
+        run_start = run_end;
+    }
+}
+
+size_t PoolManager::get_pool_count() const {
+    RcuDomain::ReadGuard guard(rcu_);
+    const SizeClassTable* table = size_class_table_.load(std::memory_order_acquire);
+    size_t count = 0;
+    for (const SizeClassTable::NodeClasses& classes : table->nodes) {
+        count += classes.pools.size();
+    }
+    return count;
+}
+
+PoolManagerStatistics PoolManager::get_statistics(PoolStatistics* pools, size_t capacity) const {
+    PoolManagerStatistics stats;
+    stats.pool_count = 0;
+    stats.pools_filled = 0;
+    stats.pools = pools;
+    {
+        // The snapshot, not numa_pools_: no manager_mutex_, and pools are never freed while
+        // the manager lives, so their (lock-free) getters are safe to call from here.
+        RcuDomain::ReadGuard guard(rcu_);
+        const SizeClassTable* table = size_class_table_.load(std::memory_order_acquire);
+        for (const SizeClassTable::NodeClasses& classes : table->nodes) {
+            for (const SizeClassTable::Entry& entry : classes.pools) {
+                if (stats.pools_filled < capacity) {
+                    pools[stats.pools_filled++] = entry.pool->get_statistics();
+                }
+                ++stats.pool_count;
+            }
+        }
+    }
+    stats.events_recorded = event_log_.recorded_count();
+    stats.events_suppressed = event_log_.suppressed_count();
+    stats.events_dropped = event_log_.dropped_count();
+    return stats;
+}
+
+PoolManagerStatistics PoolManager::get_statistics(std::vector<PoolStatistics>& pools) const {
+    for (;;) {
+        PoolManagerStatistics stats = get_statistics(pools.data(), pools.size());
+        if (!stats.truncated()) {
+            return stats;
+        }
+        pools.resize(stats.pool_count); // A pool was added since the last call
+    }
+}
+
 void PoolManager::print_stats() const {
-    std::lock_guard<std::mutex> lock(manager_mutex_);
+    std::vector<PoolStatistics> pools;
+    const PoolManagerStatistics stats = get_statistics(pools);
     std::cout << "=============== PoolManager Statistics ===============\n";
-    if (numa_pools_.empty()) {
+    for (size_t i = 0; i < stats.pools_filled; ++i) {
+        const PoolStatistics& pool = stats.pools[i];
+        if (i == 0 || stats.pools[i - 1].numa_node != pool.numa_node) {
+            std::cout << "  NUMA Node: " << pool.numa_node
+                      << (pool.numa_node == -1 ? " (Global/Unspecified)" : "") << "\n";
+        }
+        std::cout << "    --------------------------------------------\n";
+        std::cout << "    Pool (Payload Size: " << pool.payload_size
+                  << " B, Initial Count: " << pool.initial_count << ")\n";
+        std::cout << "      Configured Headroom: " << pool.headroom << " B\n";
+        std::cout << "      Configured Tailroom: " << pool.tailroom << " B\n";
+        std::cout << "      Memory Backing:      " << memory_backing_name(pool.memory_backing)
+                  << " (" << pool.memory_footprint << " B mapped)\n";
+        std::cout << "      NUMA Binding:        "
+                  << (pool.numa_bound ? "bound to node" : "none (first touch)") << "\n";
+        std::cout << "      Total Buffers:       " << pool.total_count << " (max " << pool.max_count << ")\n";
+        std::cout << "      Free Buffers:        " << pool.free_count << "\n";
+        std::cout << "      In Use:              " << pool.in_use_count << "\n";
+        std::cout << "      Released To OS:      " << pool.released_bytes << " B ("
+                  << pool.total_bytes_returned << " B returned in total)\n";
+        std::cout << "      Alloc Count:         " << pool.alloc_count << "\n";
+        std::cout << "      Dealloc Count:       " << pool.free_count_total << "\n";
+        std::cout << "      Alloc Failures:      " << pool.alloc_failures << "\n";
+        std::cout << "      High Water Mark:     " << pool.high_water_mark << "\n";
+        std::cout << "      Cache Hit Rate:      " << pool.cache_hit_rate * 100.0 << " %\n";
+    }
+    if (stats.pool_count == 0) {
         std::cout << "  No pools configured.\n";
-    } else {
-        for (const auto& numa_entry : numa_pools_) {
-            std::cout << "  NUMA Node: " << numa_entry.first 
-                      << (numa_entry.first == -1 ? " (Global/Unspecified)" : "") << "\n";
-            if (numa_entry.second.empty()) {
-                std::cout << "    No pools for this NUMA node.\n";
-                continue;
-            }
-            for (const auto& size_entry : numa_entry.second) {
-                const PacketBufferPool* pool = size_entry.second.get();
-                if (pool) {
-                    std::cout << "    --------------------------------------------\n";
-                    std::cout << "    Pool (Payload Size: " << pool->get_buffer_payload_size() 
-                              << " B, Initial Count: " << pool->get_initial_pool_count() << ")\n";
-                    std::cout << "      Configured Headroom: " << pool->get_headroom_size() << " B\n";
-                    std::cout << "      Configured Tailroom: " << pool->get_tailroom_size() << " B\n";
-                    std::cout << "      Free Buffers:        " << pool->get_free_count() << "\n";
-                    std::cout << "      Alloc Count:         " << pool->get_alloc_count() << "\n";
-                    std::cout << "      Dealloc Count:       " << pool->get_dealloc_count() << "\n";
-                    // std::cout << "      High Water Mark: " << pool->get_high_water_mark() << "\n"; // If implemented
-                } else {
-                    std::cout << "    Pool (Payload Size: " << size_entry.first << ") - ERROR: Pool pointer is null!\n";
+    }
+    std::cout << "  Events: " << stats.events_recorded << " logged, " << stats.events_suppressed
+              << " suppressed, " << stats.events_dropped << " dropped\n";
+    std::cout << "======================================================" << std::endl;
+}
+
+void PoolManager::set_statistics_callback(StatisticsCallback on_sample, UtilizationAlertCallback on_alert,
+                                          const StatisticsCallbackConfig& config) {
+    std::lock_guard<std::mutex> control(sampler_control_mutex_);
+    {
+        std::lock_guard<std::mutex> lock(sampler_mutex_);
+        sampler_stop_ = true;
+    }
+    sampler_cv_.notify_all();
+    if (sampler_thread_.joinable()) {
+        sampler_thread_.join();
+    }
+    sampler_stop_ = false;
+    sampler_thread_ = std::thread(&PoolManager::run_statistics_sampler, this, std::move(on_sample),
+                                  std::move(on_alert), config);
+}
+
+void PoolManager::clear_statistics_callback() {
+    std::lock_guard<std::mutex> control(sampler_control_mutex_);
+    {
+        std::lock_guard<std::mutex> lock(sampler_mutex_);
+        sampler_stop_ = true;
+    }
+    sampler_cv_.notify_all();
+    if (sampler_thread_.joinable()) {
+        sampler_thread_.join();
+    }
+}
+
+void PoolManager::run_statistics_sampler(StatisticsCallback on_sample, UtilizationAlertCallback on_alert,
+                                         StatisticsCallbackConfig config) {
+    // Pools currently in the raised state, by (node, payload size). Pools are never
+    // removed, so entries only leave this list by clearing.
+    std::vector<std::pair<int, size_t>> alerted;
+    std::vector<PoolStatistics> pools; // Reused, so sampling allocates only as pools are added
+
+    std::unique_lock<std::mutex> lock(sampler_mutex_);
+    while (!sampler_stop_) {
+        lock.unlock();
+        const PoolManagerStatistics stats = get_statistics(pools);
+        if (on_sample) {
+            on_sample(stats);
+        }
+        if (on_alert) {
+            for (size_t i = 0; i < stats.pools_filled; ++i) {
+                const PoolStatistics& pool = stats.pools[i];
+                const std::pair<int, size_t> key(pool.numa_node, pool.payload_size);
+                auto it = std::find(alerted.begin(), alerted.end(), key);
+                const bool was_raised = it != alerted.end();
+                if (!was_raised && pool.utilization > config.raise_utilization) {
+                    alerted.push_back(key);
+                    on_alert({pool.numa_node, pool.payload_size, pool.utilization, true});
+                } else if (was_raised && pool.utilization <= config.clear_utilization) {
+                    alerted.erase(it);
+                    on_alert({pool.numa_node, pool.payload_size, pool.utilization, false});
                 }
             }
         }
+        lock.lock();
+        sampler_cv_.wait_for(lock, config.interval, [this]() { return sampler_stop_; });
     }
-    std::cout << "======================================================" << std::endl;
 }
@@ -0,0 +1,244 @@
+#include "pool_memory.hpp"
+#include "numa_topology.hpp"
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <utility> // For std::swap
+
+#ifndef MAP_HUGE_SHIFT
+#define MAP_HUGE_SHIFT 26
+#endif
+#ifndef MAP_HUGE_2MB
+#define MAP_HUGE_2MB (21 << MAP_HUGE_SHIFT)
+#endif
+#ifndef MAP_HUGE_1GB
+#define MAP_HUGE_1GB (30 << MAP_HUGE_SHIFT)
+#endif
+
+namespace {
+
+constexpr size_t kHugePage2M = size_t(2) << 20;
+constexpr size_t kHugePage1G = size_t(1) << 30;
+
+// Memory policy constants from <linux/mempolicy.h>; spelled out so neither libnuma nor
+// its headers are needed.
+constexpr int kMpolPreferred = 1;
+constexpr size_t kMaxNumaNodes = 1024;
+constexpr size_t kBitsPerLong = sizeof(unsigned long) * 8;
+
+size_t round_up(size_t value, size_t multiple) {
+    return (value + multiple - 1) / multiple * multiple;
+}
+
+void* map_anonymous(size_t length, int extra_flags) {
+    void* p = ::mmap(nullptr, length, PROT_READ | PROT_WRITE,
+                     MAP_PRIVATE | MAP_ANONYMOUS | extra_flags, -1, 0);
+    return p == MAP_FAILED ? nullptr : p;
+}
+
+// MADV_HUGEPAGE succeeds whenever the kernel has THP compiled in, even with the policy set
+// to "never", so check the policy as well before claiming THP backing.
+bool transparent_hugepages_enabled() {
+    std::ifstream policy("/sys/kernel/mm/transparent_hugepage/enabled");
+    std::string line;
+    if (!policy || !std::getline(policy, line)) {
+        return false;
+    }
+    return line.find("[never]") == std::string::npos;
+}
+
+// MPOL_PREFERRED rather than MPOL_BIND: if the node runs out of memory the pre-fault below
+// degrades to remote pages instead of OOM-killing (or SIGBUSing, for hugetlb) the process
+// mid-construction. page_nodes() shows what was actually obtained.
+bool bind_to_node(void* base, size_t length, int node) {
+    unsigned long nodemask[kMaxNumaNodes / kBitsPerLong] = {};
+    nodemask[node / kBitsPerLong] |= 1UL << (node % kBitsPerLong);
+    // The kernel treats maxnode as "bits + 1" (it decrements it before use).
+    long rc = ::syscall(SYS_mbind, base, length, kMpolPreferred, nodemask, kMaxNumaNodes + 1, 0);
+    return rc == 0;
+}
+
+} // namespace
+
+const char* memory_backing_name(MemoryBacking backing) {
+    switch (backing) {
+        case MemoryBacking::Default:             return "4K pages";
+        case MemoryBacking::TransparentHugepage: return "transparent hugepages";
+        case MemoryBacking::Hugepage2M:          return "2MB hugepages";
+        case MemoryBacking::Hugepage1G:          return "1GB hugepages";
+    }
+    return "unknown";
+}
+
+PoolMemory::PoolMemory(unsigned char* base, size_t length, MemoryBacking backing)
+: base_(base), length_(length), backing_(backing) {}
+
+size_t PoolMemory::page_size() const {
+    switch (backing_) {
+        case MemoryBacking::Hugepage1G: return kHugePage1G;
+        case MemoryBacking::Hugepage2M: return kHugePage2M;
+        default:                        return static_cast<size_t>(::sysconf(_SC_PAGESIZE));
+    }
+}
+
+size_t PoolMemory::release_granule() const {
+    return backing_ == MemoryBacking::TransparentHugepage ? kHugePage2M : page_size();
+}
+
+PoolMemory::~PoolMemory() {
+    reset();
+}
+
+PoolMemory::PoolMemory(PoolMemory&& other) noexcept {
+    std::swap(base_, other.base_);
+    std::swap(length_, other.length_);
+    std::swap(backing_, other.backing_);
+    std::swap(bound_node_, other.bound_node_);
+}
+
+PoolMemory& PoolMemory::operator=(PoolMemory&& other) noexcept {
+    if (this != &other) {
+        reset();
+        std::swap(base_, other.base_);
+        std::swap(length_, other.length_);
+        std::swap(backing_, other.backing_);
+        std::swap(bound_node_, other.bound_node_);
+    }
+    return *this;
+}
+
+void PoolMemory::reset() {
+    if (base_) {
+        ::munmap(base_, length_);
+    }
+    base_ = nullptr;
+    length_ = 0;
+    backing_ = MemoryBacking::Default;
+    bound_node_ = -1;
+}
+
+PoolMemory PoolMemory::map(size_t length, MemoryBacking requested, int numa_node) {
+    PoolMemory mem = map_unplaced(length, requested);
+    if (!mem.base_) {
+        return mem;
+    }
+    // The policy must be in place before the first touch; nothing has faulted in yet.
+    if (numa_node >= 0 && static_cast<size_t>(numa_node) < kMaxNumaNodes &&
+        NumaTopology::is_online(numa_node) && bind_to_node(mem.base_, mem.length_, numa_node)) {
+        mem.bound_node_ = numa_node;
+    }
+    mem.prefault();
+    return mem;
+}
+
+void PoolMemory::prefault() {
+    // One write per page allocates it now, under the policy set above, instead of on the
+    // data path. Writing the existing (zero) value keeps the contents unchanged.
+    const size_t step = page_size();
+    for (size_t offset = 0; offset < length_; offset += step) {
+        volatile unsigned char* p = base_ + offset;
+        *p = *p;
+    }
+}
+
+std::vector<int> PoolMemory::page_nodes() const {
+    std::vector<int> nodes;
+    if (!base_) {
+        return nodes;
+    }
+    const size_t step = page_size();
+    const size_t count = (length_ + step - 1) / step;
+    std::vector<void*> pages(count);
+    for (size_t i = 0; i < count; ++i) {
+        pages[i] = base_ + i * step;
+    }
+    nodes.assign(count, -ENOENT);
+    // With a null target-node array, move_pages only reports where each page lives.
+    long rc = ::syscall(SYS_move_pages, 0, static_cast<unsigned long>(count), pages.data(),
+                        nullptr, nodes.data(), 0);
+    if (rc < 0) {
+        nodes.assign(count, -errno);
+    }
+    return nodes;
+}
+
+size_t PoolMemory::release(unsigned char* begin, size_t length, bool lazy) {
+    if (!base_ || begin < base_ || begin + length > base_ + length_) {
+        return 0;
+    }
+    const size_t granule = release_granule();
+    const uintptr_t start = round_up(reinterpret_cast<uintptr_t>(begin), granule);
+    const uintptr_t end = (reinterpret_cast<uintptr_t>(begin) + length) / granule * granule;
+    if (end <= start) {
+        return 0;
+    }
+    void* addr = reinterpret_cast<void*>(start);
+    const size_t bytes = end - start;
+    const bool hugetlb = backing_ == MemoryBacking::Hugepage2M || backing_ == MemoryBacking::Hugepage1G;
+#ifdef MADV_FREE
+    // MADV_FREE only applies to private anonymous memory, not hugetlbfs.
+    if (lazy && !hugetlb && ::madvise(addr, bytes, MADV_FREE) == 0) {
+        return bytes;
+    }
+#else
+    (void)lazy;
+    (void)hugetlb;
+#endif
+    return ::madvise(addr, bytes, MADV_DONTNEED) == 0 ? bytes : 0;
+}
+
+PoolMemory PoolMemory::map_unplaced(size_t length, MemoryBacking requested) {
+    if (length == 0) {
+        return PoolMemory();
+    }
+
+    // Reserved hugetlbfs pages, largest requested size first. These fail cleanly (ENOMEM)
+    // when the per-size pool in /sys/kernel/mm/hugepages is empty.
+    if (requested == MemoryBacking::Hugepage1G) {
+        size_t rounded = round_up(length, kHugePage1G);
+        if (void* p = map_anonymous(rounded, MAP_HUGETLB | MAP_HUGE_1GB)) {
+            return PoolMemory(static_cast<unsigned char*>(p), rounded, MemoryBacking::Hugepage1G);
+        }
+    }
+    if (requested == MemoryBacking::Hugepage1G || requested == MemoryBacking::Hugepage2M) {
+        size_t rounded = round_up(length, kHugePage2M);
+        if (void* p = map_anonymous(rounded, MAP_HUGETLB | MAP_HUGE_2MB)) {
+            return PoolMemory(static_cast<unsigned char*>(p), rounded, MemoryBacking::Hugepage2M);
+        }
+    }
+
+    const size_t page_size = static_cast<size_t>(::sysconf(_SC_PAGESIZE));
+    const size_t rounded = round_up(length, page_size);
+
+    if (requested != MemoryBacking::Default && transparent_hugepages_enabled()) {
+        // Over-map by one huge page and trim, so the region starts on a 2MB boundary and
+        // khugepaged can back all of it (an unaligned head/tail can only ever be 4K pages).
+        size_t padded = rounded + kHugePage2M;
+        if (void* p = map_anonymous(padded, 0)) {
+            uintptr_t start = reinterpret_cast<uintptr_t>(p);
+            uintptr_t aligned = (start + kHugePage2M - 1) & ~(uintptr_t(kHugePage2M) - 1);
+            size_t head = aligned - start;
+            size_t tail = padded - head - rounded;
+            if (head) {
+                ::munmap(p, head);
+            }
+            if (tail) {
+                ::munmap(reinterpret_cast<void*>(aligned + rounded), tail);
+            }
+            void* base = reinterpret_cast<void*>(aligned);
+            if (::madvise(base, rounded, MADV_HUGEPAGE) == 0) {
+                return PoolMemory(static_cast<unsigned char*>(base), rounded, MemoryBacking::TransparentHugepage);
+            }
+            return PoolMemory(static_cast<unsigned char*>(base), rounded, MemoryBacking::Default);
+        }
+    }
+
+    if (void* p = map_anonymous(rounded, 0)) {
+        return PoolMemory(static_cast<unsigned char*>(p), rounded, MemoryBacking::Default);
+    }
+    return PoolMemory();
+}
@@ -0,0 +1,43 @@
+#include "pool_telemetry.hpp"
+#include <cmath> // For std::ceil
+
+uint64_t LatencyHistogram::value_at_percentile(double percentile) const {
+    if (total_ == 0) {
+        return 0;
+    }
+    if (percentile < 0.0) {
+        percentile = 0.0;
+    } else if (percentile > 100.0) {
+        percentile = 100.0;
+    }
+    uint64_t rank = static_cast<uint64_t>(std::ceil(percentile / 100.0 * static_cast<double>(total_)));
+    if (rank == 0) {
+        rank = 1;
+    }
+    uint64_t seen = 0;
+    for (size_t i = 0; i < counts_.size(); ++i) {
+        seen += counts_[i];
+        if (seen >= rank) {
+            return bucket_lower_bound(i);
+        }
+    }
+    return bucket_lower_bound(counts_.size() - 1);
+}
+
+uint64_t LatencyHistogram::min() const {
+    for (size_t i = 0; i < counts_.size(); ++i) {
+        if (counts_[i]) {
+            return bucket_lower_bound(i);
+        }
+    }
+    return 0;
+}
+
+uint64_t LatencyHistogram::max() const {
+    for (size_t i = counts_.size(); i-- > 0;) {
+        if (counts_[i]) {
+            return bucket_lower_bound(i);
+        }
+    }
+    return 0;
+}
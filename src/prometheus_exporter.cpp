@@ -0,0 +1,244 @@
+#include "prometheus_exporter.hpp"
+#include <cstdarg> // For va_list
+#include <cstdio>  // For vsnprintf
+#include <cstring>
+#include <arpa/inet.h>  // For inet_pton, htons
+#include <netinet/in.h> // For sockaddr_in
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>     // For close
+
+namespace {
+
+// snprintf-style appender: keeps counting past the end of the buffer so the caller
+// learns how much room the full text needs.
+class TextWriter {
+public:
+    TextWriter(char* out, size_t capacity) : out_(out), capacity_(capacity) {
+        if (capacity_ > 0) {
+            out_[0] = '\0';
+        }
+    }
+
+    void append(const char* fmt, ...) __attribute__((format(printf, 2, 3))) {
+        char* dst = length_ < capacity_ ? out_ + length_ : nullptr;
+        size_t room = length_ < capacity_ ? capacity_ - length_ : 0;
+        va_list args;
+        va_start(args, fmt);
+        int n = std::vsnprintf(dst, room, fmt, args);
+        va_end(args);
+        if (n > 0) {
+            length_ += static_cast<size_t>(n);
+        }
+    }
+
+    size_t length() const { return length_; }
+
+private:
+    char* out_;
+    size_t capacity_;
+    size_t length_ = 0;
+};
+
+struct PoolMetric {
+    const char* name; // Family name; counters get the _total suffix on their samples
+    bool counter;
+    const char* help;
+    unsigned long long (*value)(const PoolStatistics&);
+};
+
+#define POOL_FIELD(field) [](const PoolStatistics& s) { return static_cast<unsigned long long>(s.field); }
+
+const PoolMetric kPoolMetrics[] = {
+    {"packetbuffer_pool_buffers", false, "Buffers owned by the pool, including grown chunks.", POOL_FIELD(total_count)},
+    {"packetbuffer_pool_max_buffers", false, "Upper bound the pool may grow to.", POOL_FIELD(max_count)},
+    {"packetbuffer_pool_free_buffers", false, "Buffers on the free list or in thread caches.", POOL_FIELD(free_count)},
+    {"packetbuffer_pool_in_use_buffers", false, "Buffers currently handed out.", POOL_FIELD(in_use_count)},
+    {"packetbuffer_pool_in_use_high_water_mark", false, "Most buffers ever in use at once.", POOL_FIELD(high_water_mark)},
+    {"packetbuffer_pool_memory_bytes", false, "Bytes mapped for the pool's chunks.", POOL_FIELD(memory_footprint)},
+    {"packetbuffer_pool_released_bytes", false, "Mapped bytes currently handed back to the kernel.", POOL_FIELD(released_bytes)},
+    {"packetbuffer_pool_returned_bytes", true, "Bytes handed back to the kernel by idle-region shrinking.", POOL_FIELD(total_bytes_returned)},
+    {"packetbuffer_pool_allocations", true, "Buffers allocated.", POOL_FIELD(alloc_count)},
+    {"packetbuffer_pool_frees", true, "Buffers returned to the pool.", POOL_FIELD(free_count_total)},
+    {"packetbuffer_pool_allocation_failures", true, "Allocation calls that found the pool exhausted.", POOL_FIELD(alloc_failures)},
+    {"packetbuffer_pool_cache_hits", true, "Allocations served from a per-thread cache.", POOL_FIELD(cache_hits)},
+    {"packetbuffer_pool_cache_misses", true, "Allocations that had to refill a per-thread cache.", POOL_FIELD(cache_misses)},
+    {"packetbuffer_pool_remote_frees", true, "Buffers freed by other nodes' threads through return queues.", POOL_FIELD(remote_frees)},
+};
+
+#undef POOL_FIELD
+
+} // namespace
+
+std::shared_ptr<PrometheusExporter> PrometheusExporter::create(PoolManager& manager) {
+    return std::make_shared<PrometheusExporter>(manager);
+}
+
+PrometheusExporter::PrometheusExporter(PoolManager& manager) : manager_(manager) {}
+
+PrometheusExporter::~PrometheusExporter() {
+    stop_http_server();
+}
+
+size_t PrometheusExporter::render(const PoolManagerStatistics& stats, char* out, size_t capacity) {
+    TextWriter w(out, capacity);
+
+    // OpenMetrics wants every sample of a family contiguous, so iterate family-major.
+    for (const PoolMetric& metric : kPoolMetrics) {
+        w.append("# TYPE %s %s\n# HELP %s %s\n", metric.name, metric.counter ? "counter" : "gauge",
+                 metric.name, metric.help);
+        for (size_t i = 0; i < stats.pools_filled; ++i) {
+            const PoolStatistics& pool = stats.pools[i];
+            w.append("%s%s{node=\"%d\",size=\"%zu\"} %llu\n", metric.name, metric.counter ? "_total" : "",
+                     pool.numa_node, pool.payload_size, metric.value(pool));
+        }
+    }
+
+    // Info families are named without the suffix their samples carry.
+    w.append("# TYPE packetbuffer_pool info\n"
+             "# HELP packetbuffer_pool Static pool configuration.\n");
+    for (size_t i = 0; i < stats.pools_filled; ++i) {
+        const PoolStatistics& pool = stats.pools[i];
+        w.append("packetbuffer_pool_info{node=\"%d\",size=\"%zu\",headroom=\"%zu\",tailroom=\"%zu\","
+                 "backing=\"%s\",numa_bound=\"%s\"} 1\n",
+                 pool.numa_node, pool.payload_size, pool.headroom, pool.tailroom,
+                 memory_backing_name(pool.memory_backing), pool.numa_bound ? "true" : "false");
+    }
+
+    w.append("# TYPE packetbuffer_pools gauge\n"
+             "# HELP packetbuffer_pools Pools configured in the manager.\n"
+             "packetbuffer_pools %zu\n",
+             stats.pool_count);
+    w.append("# TYPE packetbuffer_events counter\n"
+             "# HELP packetbuffer_events Allocation-failure events by what happened to them.\n"
+             "packetbuffer_events_total{outcome=\"recorded\"} %llu\n"
+             "packetbuffer_events_total{outcome=\"suppressed\"} %llu\n"
+             "packetbuffer_events_total{outcome=\"dropped\"} %llu\n",
+             static_cast<unsigned long long>(stats.events_recorded),
+             static_cast<unsigned long long>(stats.events_suppressed),
+             static_cast<unsigned long long>(stats.events_dropped));
+    w.append("# EOF\n");
+    return w.length();
+}
+
+size_t PrometheusExporter::render(char* out, size_t capacity) const {
+    std::lock_guard<std::mutex> lock(snapshot_mutex_);
+    const PoolManagerStatistics stats = manager_.get_statistics(pools_);
+    return render(stats, out, capacity);
+}
+
+bool PrometheusExporter::start_http_server(uint16_t port, const char* bind_address, size_t body_capacity) {
+    if (http_thread_.joinable() || body_capacity == 0) {
+        return false;
+    }
+
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    if (inet_pton(AF_INET, bind_address, &addr.sin_addr) != 1) {
+        return false;
+    }
+
+    int fd = ::socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        return false;
+    }
+    int one = 1;
+    ::setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+    socklen_t addr_len = sizeof(addr);
+    if (::bind(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0 ||
+        ::listen(fd, 16) != 0 ||
+        ::getsockname(fd, reinterpret_cast<sockaddr*>(&addr), &addr_len) != 0) {
+        ::close(fd);
+        return false;
+    }
+
+    body_.reset(new char[body_capacity]);
+    body_capacity_ = body_capacity;
+    listen_fd_ = fd;
+    http_port_ = ntohs(addr.sin_port);
+    http_stop_.store(false, std::memory_order_relaxed);
+    http_thread_ = std::thread(&PrometheusExporter::serve, this);
+    return true;
+}
+
+void PrometheusExporter::stop_http_server() {
+    if (!http_thread_.joinable()) {
+        return;
+    }
+    http_stop_.store(true, std::memory_order_relaxed);
+    http_thread_.join();
+    ::close(listen_fd_);
+    listen_fd_ = -1;
+    http_port_ = 0;
+}
+
+void PrometheusExporter::serve() {
+    // Poll with a short timeout so stop_http_server() never has to interrupt accept().
+    pollfd pfd{listen_fd_, POLLIN, 0};
+    while (!http_stop_.load(std::memory_order_relaxed)) {
+        if (::poll(&pfd, 1, 100) <= 0 || !(pfd.revents & POLLIN)) {
+            continue;
+        }
+        int client = ::accept4(listen_fd_, nullptr, nullptr, SOCK_CLOEXEC);
+        if (client >= 0) {
+            handle_connection(client);
+            ::close(client);
+        }
+    }
+}
+
+void PrometheusExporter::handle_connection(int client) {
+    // A scraper sends a small GET; read just enough to see the request line.
+    timeval timeout{1, 0};
+    ::setsockopt(client, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    ::setsockopt(client, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+    char request[1024];
+    size_t got = 0;
+    while (got < sizeof(request) - 1) {
+        ssize_t n = ::recv(client, request + got, sizeof(request) - 1 - got, 0);
+        if (n <= 0) {
+            break;
+        }
+        got += static_cast<size_t>(n);
+        request[got] = '\0';
+        if (std::strstr(request, "\r\n\r\n") || std::strstr(request, "\n\n")) {
+            break;
+        }
+    }
+    request[got] = '\0';
+
+    const bool is_metrics = std::strncmp(request, "GET /metrics ", 13) == 0 ||
+                            std::strncmp(request, "GET /metrics?", 13) == 0;
+    const char* status = "404 Not Found";
+    const char* content_type = "text/plain; charset=utf-8";
+    size_t body_len = 0;
+    if (is_metrics) {
+        body_len = render(body_.get(), body_capacity_);
+        if (body_len < body_capacity_) {
+            status = "200 OK";
+            content_type = kContentType;
+        } else {
+            status = "500 Internal Server Error"; // Exposition outgrew body_capacity
+            body_len = 0;
+        }
+    }
+
+    char header[256];
+    int header_len = std::snprintf(header, sizeof(header),
+                                   "HTTP/1.1 %s\r\nContent-Type: %s\r\nContent-Length: %zu\r\n"
+                                   "Connection: close\r\n\r\n",
+                                   status, content_type, body_len);
+    const char* parts[2] = {header, body_.get()};
+    size_t lengths[2] = {static_cast<size_t>(header_len), body_len};
+    for (int p = 0; p < 2; ++p) {
+        size_t sent = 0;
+        while (sent < lengths[p]) {
+            ssize_t n = ::send(client, parts[p] + sent, lengths[p] - sent, MSG_NOSIGNAL);
+            if (n <= 0) {
+                return;
+            }
+            sent += static_cast<size_t>(n);
+        }
+    }
+}
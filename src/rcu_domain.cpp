@@ -0,0 +1,61 @@
+#include "rcu_domain.hpp"
+#include <linux/membarrier.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <thread>
+
+namespace {
+
+long membarrier(int cmd) {
+    return ::syscall(SYS_membarrier, cmd, 0, 0);
+}
+
+thread_local uint32_t slotless_nesting = 0;
+
+} // namespace
+
+RcuDomain::RcuDomain() {
+    long supported = membarrier(MEMBARRIER_CMD_QUERY);
+    if (supported > 0 && (supported & MEMBARRIER_CMD_PRIVATE_EXPEDITED) &&
+        membarrier(MEMBARRIER_CMD_REGISTER_PRIVATE_EXPEDITED) == 0) {
+        use_membarrier_ = true;
+    }
+}
+
+void RcuDomain::slotless_read_lock() {
+    if (slotless_nesting++ == 0) {
+        slotless_readers_.fetch_add(1, std::memory_order_seq_cst);
+    }
+}
+
+void RcuDomain::slotless_read_unlock() {
+    if (--slotless_nesting == 0) {
+        slotless_readers_.fetch_sub(1, std::memory_order_release);
+    }
+}
+
+void RcuDomain::synchronize() {
+    // Readers that announced an epoch older than target may hold the old version.
+    const uint64_t target = global_epoch_.fetch_add(1, std::memory_order_seq_cst) + 1;
+
+    // Pairs with reader_fence(): after this, every reader's epoch announcement that
+    // preceded a load of the old pointer is visible to the scan below.
+    if (use_membarrier_) {
+        membarrier(MEMBARRIER_CMD_PRIVATE_EXPEDITED);
+    } else {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+    }
+
+    for (ReaderState& reader : readers_) {
+        for (;;) {
+            uint64_t epoch = reader.epoch.load(std::memory_order_acquire);
+            if (epoch == kQuiescent || epoch >= target) {
+                break;
+            }
+            std::this_thread::yield();
+        }
+    }
+    while (slotless_readers_.load(std::memory_order_acquire) != 0) {
+        std::this_thread::yield();
+    }
+}
@@ -0,0 +1,54 @@
+#include "thread_slot.hpp"
+#include <atomic>
+#include <bitset>
+#include <mutex>
+
+namespace {
+
+std::mutex slot_mutex;                      // Only taken on thread start/exit
+std::bitset<ThreadSlot::kMaxSlots> slot_in_use;
+std::atomic<size_t> slot_bound{0};          // Only grows; written under slot_mutex
+
+} // namespace
+
+// Hands the slot back when the owning thread exits. Thread-local destructors that run
+// after this one (a per-thread object that still frees buffers, ...) then see kNone rather
+// than a slot another thread may already own.
+struct ThreadSlot::Releaser {
+    size_t slot = kNone;
+    ~Releaser() {
+        cached_slot_ = kNone;
+        if (slot != kNone) {
+            std::lock_guard<std::mutex> lock(slot_mutex);
+            slot_in_use.reset(slot);
+        }
+    }
+};
+
+thread_local ThreadSlot::Releaser ThreadSlot::releaser_;
+
+size_t ThreadSlot::acquire() {
+    size_t slot = kNone;
+    {
+        std::lock_guard<std::mutex> lock(slot_mutex);
+        for (size_t i = 0; i < kMaxSlots; ++i) {
+            if (!slot_in_use.test(i)) {
+                slot_in_use.set(i);
+                slot = i;
+                if (i + 1 > slot_bound.load(std::memory_order_relaxed)) {
+                    slot_bound.store(i + 1, std::memory_order_release);
+                }
+                break;
+            }
+        }
+    }
+    // kNone is cached too: a thread that found the table full stays on the shared paths
+    // rather than retrying the mutex on every call.
+    releaser_.slot = slot;
+    cached_slot_ = slot;
+    return slot;
+}
+
+size_t ThreadSlot::assigned_bound() {
+    return slot_bound.load(std::memory_order_acquire);
+}
@@ -0,0 +1,180 @@
+#include "gtest/gtest.h"
+#include "buffer_ring.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+namespace {
+
+// The rings never dereference what they carry, so tests pass tagged integers.
+PacketBuffer* tag(uintptr_t value) { return reinterpret_cast<PacketBuffer*>(value); }
+uintptr_t untag(PacketBuffer* buf) { return reinterpret_cast<uintptr_t>(buf); }
+
+template <typename Ring>
+class BufferRingTest : public ::testing::Test {};
+
+using RingTypes = ::testing::Types<SpscBufferRing, MpscBufferRing, MpmcBufferRing>;
+TYPED_TEST_SUITE(BufferRingTest, RingTypes);
+
+} // namespace
+
+TYPED_TEST(BufferRingTest, BurstAndBulkSemantics) {
+    TypeParam ring(8);
+    EXPECT_EQ(ring.capacity(), 8u);
+    EXPECT_TRUE(ring.empty());
+    EXPECT_EQ(ring.dequeue(), nullptr);
+
+    PacketBuffer* in[12];
+    for (uintptr_t i = 0; i < 12; ++i) {
+        in[i] = tag(i + 1);
+    }
+    EXPECT_EQ(ring.enqueue_burst(in, 5), 5u);
+    EXPECT_FALSE(ring.enqueue_bulk(in + 5, 4)); // Only 3 free: all-or-nothing refuses
+    EXPECT_EQ(ring.size(), 5u);
+    EXPECT_EQ(ring.enqueue_burst(in + 5, 7), 3u); // Burst takes what fits
+    EXPECT_FALSE(ring.enqueue(in[8]));
+
+    PacketBuffer* out[12];
+    EXPECT_FALSE(ring.dequeue_bulk(out, 9));
+    ASSERT_TRUE(ring.dequeue_bulk(out, 2));
+    EXPECT_EQ(untag(out[0]), 1u);
+    EXPECT_EQ(untag(out[1]), 2u);
+    EXPECT_EQ(ring.dequeue_burst(out, 12), 6u);
+    for (uintptr_t i = 0; i < 6; ++i) {
+        EXPECT_EQ(untag(out[i]), i + 3);
+    }
+    EXPECT_TRUE(ring.empty());
+}
+
+TYPED_TEST(BufferRingTest, CountersWrapAroundTheSlotArray) {
+    TypeParam ring(4);
+    uintptr_t next_in = 1;
+    uintptr_t next_out = 1;
+    for (int round = 0; round < 1000; ++round) {
+        PacketBuffer* in[3] = {tag(next_in), tag(next_in + 1), tag(next_in + 2)};
+        ASSERT_TRUE(ring.enqueue_bulk(in, 3));
+        next_in += 3;
+        PacketBuffer* out[3];
+        ASSERT_EQ(ring.dequeue_burst(out, 3), 3u);
+        for (PacketBuffer* buf : out) {
+            ASSERT_EQ(untag(buf), next_out++);
+        }
+    }
+}
+
+TEST(BufferRingTest, RejectsCapacityThatIsNotAPowerOfTwo) {
+    EXPECT_THROW(SpscBufferRing(0), std::invalid_argument);
+    EXPECT_THROW(MpmcBufferRing(12), std::invalid_argument);
+}
+
+TEST(BufferRingTest, SpscPreservesOrderAcrossThreads) {
+    SpscBufferRing ring(64);
+    const uintptr_t kItems = 100000;
+    std::thread producer([&]() {
+        PacketBuffer* burst[16];
+        for (uintptr_t next = 1; next <= kItems;) {
+            size_t n = std::min<uintptr_t>(16, kItems - next + 1);
+            for (size_t i = 0; i < n; ++i) {
+                burst[i] = tag(next + i);
+            }
+            size_t sent = 0;
+            while (sent < n) {
+                size_t put = ring.enqueue_burst(burst + sent, n - sent);
+                sent += put;
+                if (put == 0) {
+                    std::this_thread::yield();
+                }
+            }
+            next += n;
+        }
+    });
+    uintptr_t expected = 1;
+    bool in_order = true;
+    PacketBuffer* out[16];
+    while (expected <= kItems) {
+        size_t got = ring.dequeue_burst(out, 16);
+        for (size_t i = 0; i < got; ++i) {
+            in_order &= untag(out[i]) == expected++;
+        }
+        if (got == 0) {
+            std::this_thread::yield();
+        }
+    }
+    producer.join();
+    EXPECT_TRUE(in_order);
+    EXPECT_TRUE(ring.empty());
+}
+
+TEST(BufferRingTest, MpmcDeliversEveryBufferExactlyOnce) {
+    MpmcBufferRing ring(128);
+    const int kProducers = 4;
+    const int kConsumers = 4;
+    const uintptr_t kPerProducer = 50000;
+    std::atomic<uintptr_t> consumed{0};
+    std::vector<std::vector<uintptr_t>> seen(kConsumers);
+
+    std::vector<std::thread> threads;
+    for (int p = 0; p < kProducers; ++p) {
+        threads.emplace_back([&, p]() {
+            PacketBuffer* burst[8];
+            for (uintptr_t i = 0; i < kPerProducer; i += 8) {
+                for (uintptr_t j = 0; j < 8; ++j) {
+                    burst[j] = tag(p * kPerProducer + i + j + 1);
+                }
+                while (!ring.enqueue_bulk(burst, 8)) {
+                    std::this_thread::yield();
+                }
+            }
+        });
+    }
+    for (int c = 0; c < kConsumers; ++c) {
+        threads.emplace_back([&, c]() {
+            PacketBuffer* out[8];
+            while (consumed.load() < kProducers * kPerProducer) {
+                size_t got = ring.dequeue_burst(out, 8);
+                for (size_t i = 0; i < got; ++i) {
+                    seen[c].push_back(untag(out[i]));
+                }
+                consumed += got;
+                if (got == 0) {
+                    std::this_thread::yield();
+                }
+            }
+        });
+    }
+    for (auto& th : threads) {
+        th.join();
+    }
+
+    std::vector<uintptr_t> all;
+    for (const auto& s : seen) {
+        all.insert(all.end(), s.begin(), s.end());
+    }
+    std::sort(all.begin(), all.end());
+    ASSERT_EQ(all.size(), kProducers * kPerProducer);
+    for (uintptr_t i = 0; i < all.size(); ++i) {
+        ASSERT_EQ(all[i], i + 1);
+    }
+}
+
+TEST(BufferRingTest, HandleRingsCarryHandles) {
+    static_assert(sizeof(BufferHandle) * 2 == sizeof(PacketBuffer*), "Handle slots are half a pointer");
+    MpmcHandleRing ring(16);
+    EXPECT_FALSE(ring.dequeue().valid());
+
+    BufferHandle in[5];
+    for (uint32_t i = 0; i < 5; ++i) {
+        in[i] = BufferHandle::make(3, i * 7);
+    }
+    EXPECT_EQ(ring.enqueue_burst(in, 5), 5u);
+    EXPECT_TRUE(ring.enqueue(BufferHandle::make(4, 1)));
+    BufferHandle out[6];
+    ASSERT_TRUE(ring.dequeue_bulk(out, 6));
+    for (uint32_t i = 0; i < 5; ++i) {
+        EXPECT_EQ(out[i], in[i]);
+    }
+    EXPECT_EQ(out[5].pool_id(), 4u);
+    EXPECT_EQ(out[5].index(), 1u);
+}
@@ -0,0 +1,103 @@
+#include "gtest/gtest.h"
+#include "event_log.hpp"
+#include "pool_manager.hpp"
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+TEST(EventLogTest, RecordsAreDrainedInOrder) {
+    EventLog log(8, 100);
+    log.record(EventRecord::Type::PoolExhausted, 0, 128);
+    log.record(EventRecord::Type::NoSuitablePool, 1, 4096, 32);
+
+    std::vector<EventRecord> seen;
+    EXPECT_EQ(log.drain([&seen](const EventRecord& r) { seen.push_back(r); }), 2u);
+    ASSERT_EQ(seen.size(), 2u);
+    EXPECT_EQ(seen[0].type, EventRecord::Type::PoolExhausted);
+    EXPECT_EQ(seen[0].payload_size, 128u);
+    EXPECT_EQ(seen[1].type, EventRecord::Type::NoSuitablePool);
+    EXPECT_EQ(seen[1].numa_node, 1);
+    EXPECT_EQ(seen[1].count, 32u);
+    EXPECT_LE(seen[0].timestamp_ns, seen[1].timestamp_ns);
+    EXPECT_EQ(log.drain(EventLog::Sink()), 0u);
+    EXPECT_EQ(log.recorded_count(), 2u);
+}
+
+TEST(EventLogTest, RateLimitSuppressesPerType) {
+    EventLog log(64, 4, std::chrono::hours(1));
+    for (int i = 0; i < 10; ++i) {
+        log.record(EventRecord::Type::PoolExhausted, 0, 64);
+    }
+    log.record(EventRecord::Type::NoSuitablePool, 0, 64); // Own budget
+
+    EXPECT_EQ(log.recorded_count(), 5u);
+    EXPECT_EQ(log.suppressed_count(EventRecord::Type::PoolExhausted), 6u);
+    EXPECT_EQ(log.suppressed_count(EventRecord::Type::NoSuitablePool), 0u);
+    EXPECT_EQ(log.suppressed_count(), 6u);
+    EXPECT_EQ(log.drain(EventLog::Sink()), 5u);
+}
+
+TEST(EventLogTest, FullRingDropsNewRecords) {
+    EventLog log(4, 100);
+    for (int i = 0; i < 6; ++i) {
+        log.record(EventRecord::Type::PoolExhausted, 0, static_cast<size_t>(i));
+    }
+    EXPECT_EQ(log.recorded_count(), 4u);
+    EXPECT_EQ(log.dropped_count(), 2u);
+
+    std::vector<size_t> sizes;
+    log.drain([&sizes](const EventRecord& r) { sizes.push_back(r.payload_size); });
+    EXPECT_EQ(sizes, (std::vector<size_t>{0, 1, 2, 3}));
+
+    log.record(EventRecord::Type::PoolExhausted, 0, 99); // Space again after draining
+    EXPECT_EQ(log.drain(EventLog::Sink()), 1u);
+}
+
+TEST(EventLogTest, ConcurrentProducersWithBackgroundDrain) {
+    const int kThreads = 4;
+    const int kPerThread = 2000;
+    EventLog log(256, kThreads * kPerThread);
+    std::atomic<size_t> drained{0};
+    log.start_background_drain([&drained](const EventRecord&) { drained.fetch_add(1); },
+                               std::chrono::milliseconds(1));
+
+    std::vector<std::thread> producers;
+    for (int t = 0; t < kThreads; ++t) {
+        producers.emplace_back([&log, t]() {
+            for (int i = 0; i < kPerThread; ++i) {
+                log.record(EventRecord::Type::PoolExhausted, t, 64);
+            }
+        });
+    }
+    for (auto& th : producers) {
+        th.join();
+    }
+    log.stop_background_drain(); // Drains once more before exiting
+
+    EXPECT_EQ(log.recorded_count() + log.dropped_count(), static_cast<uint64_t>(kThreads * kPerThread));
+    EXPECT_EQ(drained.load(), log.recorded_count());
+}
+
+TEST(EventLogTest, PoolManagerRecordsAllocationFailures) {
+    PoolManager& manager = PoolManager::instance();
+    EventLog& log = manager.event_log();
+    log.drain(EventLog::Sink());
+
+    ASSERT_TRUE(manager.add_pool(9, {256, 1}));
+    PacketBuffer* held = manager.allocate(256, 9);
+    ASSERT_NE(held, nullptr);
+    EXPECT_EQ(manager.allocate(256, 9), nullptr);       // Exhausted
+    EXPECT_EQ(manager.allocate(100000, 9), nullptr);    // Too large for any pool on node 9
+
+    std::vector<EventRecord> seen;
+    log.drain([&seen](const EventRecord& r) { seen.push_back(r); });
+    ASSERT_EQ(seen.size(), 2u);
+    EXPECT_EQ(seen[0].type, EventRecord::Type::PoolExhausted);
+    EXPECT_EQ(seen[0].numa_node, 9);
+    EXPECT_EQ(seen[1].type, EventRecord::Type::NoSuitablePool);
+    EXPECT_EQ(seen[1].payload_size, 100000u);
+    EXPECT_NE(format_event(seen[0]).find("pool_exhausted"), std::string::npos);
+
+    held->release();
+}
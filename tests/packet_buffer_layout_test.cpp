@@ -0,0 +1,57 @@
+#include "gtest/gtest.h"
+#include "packet_buffer.hpp"
+#include "packet_buffer_pool.hpp"
+#include <cstddef> // For offsetof
+#include <cstdint>
+
+// Compile-time guard for PacketBuffer's cache-line layout: every field the RX/TX fast
+// path touches must sit in the first 64 bytes. Reordering or widening a field so that one
+// spills into the second line fails the build of the test binary.
+namespace {
+
+constexpr size_t kLine = 64;
+
+template <size_t Offset, size_t Size>
+constexpr bool in_first_line() {
+    return Offset + Size <= kLine;
+}
+
+#define ASSERT_HOT(field) \
+    static_assert(in_first_line<offsetof(PacketBuffer, field), sizeof(PacketBuffer::field)>(), \
+                  "PacketBuffer::" #field " left the hot cache line")
+
+ASSERT_HOT(data_ptr_);
+ASSERT_HOT(data_len_);
+ASSERT_HOT(ref_count_);
+ASSERT_HOT(next_);
+ASSERT_HOT(buffer_start_);
+ASSERT_HOT(total_allocated_size_);
+ASSERT_HOT(headroom_);
+ASSERT_HOT(tailroom_);
+ASSERT_HOT(pool_index_);
+ASSERT_HOT(owning_pool_);
+ASSERT_HOT(metadata_);
+
+#undef ASSERT_HOT
+
+static_assert(offsetof(PacketBuffer, numa_node_) >= kLine, "Cold fields belong after the hot line");
+static_assert(sizeof(PacketBuffer) <= 2 * kLine, "PacketBuffer should span at most two cache lines");
+static_assert(std::atomic<int>::is_always_lock_free, "ref_count_ must not hide a lock");
+
+} // namespace
+
+TEST(PacketBufferLayoutTest, PoolPlacesEachBufferAtALineBoundary) {
+    PacketBufferPool pool(1500, 16, -1, 64, 16);
+    for (size_t i = 0; i < pool.get_total_count(); ++i) {
+        const PacketBuffer* buf = pool.buffers_[i];
+        EXPECT_EQ(reinterpret_cast<uintptr_t>(buf) % kLine, 0u) << "buffer " << i;
+        // Metadata shares the second line with the cold fields, ahead of the data area.
+        const unsigned char* meta = reinterpret_cast<const unsigned char*>(buf->metadata_);
+        EXPECT_GE(meta, reinterpret_cast<const unsigned char*>(buf) + sizeof(PacketBuffer));
+        EXPECT_LE(meta, buf->buffer_start_);
+    }
+}
+
+TEST(PacketBufferLayoutTest, OversizedDataAreaIsRejected) {
+    EXPECT_THROW(PacketBufferPool(size_t(UINT32_MAX), 1, -1, 64, 0), std::invalid_argument);
+}
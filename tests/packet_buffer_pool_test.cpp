@@ -2,6 +2,17 @@
 #include "packet_buffer_pool.hpp"
 #include "packet_buffer.hpp" // For PacketBuffer type
 #include "buffer_metadata.hpp" // For BufferMetadata type (used by PacketBuffer)
+#include "numa_topology.hpp"
+#include "thread_slot.hpp"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
 
 // Test fixture for PacketBufferPool tests
 class PacketBufferPoolTest : public ::testing::Test {
@@ -136,3 +147,740 @@ TEST_F(PacketBufferPoolTest, AllocateAllBuffers) {
     EXPECT_EQ(pool.get_free_count(), initial_count);
     EXPECT_EQ(pool.get_dealloc_count(), initial_count);
 }
+
+TEST_F(PacketBufferPoolTest, ConcurrentAllocateReleaseNeverHandsOutABufferTwice) {
+    const size_t initial_count = 64;
+    const int num_threads = 8;
+    const int iterations = 20000;
+    PacketBufferPool pool(64, initial_count);
+
+    // Each buffer carries an "owner" marker in its payload; if the free list ever handed the
+    // same buffer to two threads at once, one of them would observe the other's marker.
+    std::atomic<bool> duplicate_seen{false};
+    std::vector<std::thread> threads;
+    for (int t = 0; t < num_threads; ++t) {
+        threads.emplace_back([&pool, &duplicate_seen, t]() {
+            for (int i = 0; i < iterations; ++i) {
+                PacketBuffer* buf = pool.allocate_buffer();
+                if (!buf) {
+                    continue; // Transient exhaustion is fine
+                }
+                volatile unsigned char* marker = buf->data();
+                *marker = static_cast<unsigned char>(t + 1);
+                std::this_thread::yield();
+                if (*marker != static_cast<unsigned char>(t + 1)) {
+                    duplicate_seen = true;
+                }
+                buf->release();
+            }
+        });
+    }
+    for (auto& th : threads) {
+        th.join();
+    }
+
+    EXPECT_FALSE(duplicate_seen.load());
+    EXPECT_EQ(pool.get_alloc_count(), pool.get_dealloc_count());
+    EXPECT_EQ(pool.get_free_count(), initial_count);
+
+    // Every buffer must still be reachable exactly once through the free list.
+    std::vector<PacketBuffer*> drained;
+    while (PacketBuffer* buf = pool.allocate_buffer()) {
+        drained.push_back(buf);
+    }
+    EXPECT_EQ(drained.size(), initial_count);
+    std::sort(drained.begin(), drained.end());
+    EXPECT_EQ(std::adjacent_find(drained.begin(), drained.end()), drained.end());
+    for (PacketBuffer* buf : drained) {
+        buf->release();
+    }
+}
+
+TEST_F(PacketBufferPoolTest, ThreadCacheSizeIsClampedToPool) {
+    PacketBufferPool small_pool(64, 6, -1, 64, 0, 32);
+    EXPECT_EQ(small_pool.get_per_thread_cache_size(), 4u); // 2/3 of the pool
+
+    PacketBufferPool uncached_pool(64, 6);
+    EXPECT_EQ(uncached_pool.get_per_thread_cache_size(), 0u);
+}
+
+TEST_F(PacketBufferPoolTest, ThreadCacheAllocateAndReleaseAll) {
+    const size_t initial_count = 12;
+    PacketBufferPool pool(128, initial_count, -1, 64, 0, 4);
+
+    std::vector<PacketBuffer*> bufs;
+    while (PacketBuffer* buf = pool.allocate_buffer()) {
+        EXPECT_EQ(buf->ref_count(), 1);
+        bufs.push_back(buf);
+    }
+    EXPECT_EQ(bufs.size(), initial_count);
+    EXPECT_EQ(pool.get_free_count(), 0u);
+
+    for (PacketBuffer* buf : bufs) {
+        buf->release();
+    }
+    EXPECT_EQ(pool.get_free_count(), initial_count); // Cached buffers still count as free
+    EXPECT_EQ(pool.get_dealloc_count(), initial_count);
+}
+
+TEST_F(PacketBufferPoolTest, ThreadCacheHoldsBuffersUntilFlushed) {
+    const size_t initial_count = 8;
+    const size_t cache_size = 4; // Flush threshold 6
+    PacketBufferPool pool(64, initial_count, -1, 64, 0, cache_size);
+
+    // Thread A takes everything and frees it again; its cache keeps cache_size buffers.
+    std::vector<PacketBuffer*> bufs;
+    while (PacketBuffer* buf = pool.allocate_buffer()) {
+        bufs.push_back(buf);
+    }
+    ASSERT_EQ(bufs.size(), initial_count);
+    for (PacketBuffer* buf : bufs) {
+        buf->release();
+    }
+
+    auto count_from_other_thread = [&pool]() {
+        size_t got = 0;
+        std::thread other([&pool, &got]() {
+            std::vector<PacketBuffer*> taken;
+            while (PacketBuffer* buf = pool.allocate_buffer()) {
+                taken.push_back(buf);
+            }
+            got = taken.size();
+            for (PacketBuffer* buf : taken) {
+                buf->release();
+            }
+            pool.flush_thread_cache();
+        });
+        other.join();
+        return got;
+    };
+
+    EXPECT_EQ(count_from_other_thread(), initial_count - cache_size);
+
+    pool.flush_thread_cache(); // Thread A gives its cached buffers back
+    EXPECT_EQ(count_from_other_thread(), initial_count);
+}
+
+TEST_F(PacketBufferPoolTest, ConcurrentAllocateReleaseWithThreadCaches) {
+    const size_t initial_count = 256;
+    const int num_threads = 8;
+    PacketBufferPool pool(64, initial_count, -1, 64, 0, 16);
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < num_threads; ++t) {
+        threads.emplace_back([&pool]() {
+            PacketBuffer* held[8];
+            for (int i = 0; i < 5000; ++i) {
+                size_t n = 0;
+                for (; n < 8; ++n) {
+                    held[n] = pool.allocate_buffer();
+                    if (!held[n]) {
+                        break;
+                    }
+                }
+                for (size_t k = 0; k < n; ++k) {
+                    held[k]->release();
+                }
+            }
+            pool.flush_thread_cache();
+        });
+    }
+    for (auto& th : threads) {
+        th.join();
+    }
+    pool.flush_thread_cache();
+
+    std::vector<PacketBuffer*> drained;
+    while (PacketBuffer* buf = pool.allocate_buffer()) {
+        drained.push_back(buf);
+    }
+    EXPECT_EQ(drained.size(), initial_count);
+    std::sort(drained.begin(), drained.end());
+    EXPECT_EQ(std::adjacent_find(drained.begin(), drained.end()), drained.end());
+    for (PacketBuffer* buf : drained) {
+        buf->release();
+    }
+}
+
+TEST_F(PacketBufferPoolTest, AllocateBulkIsAllOrNothing) {
+    const size_t initial_count = 100;
+    PacketBufferPool pool(128, initial_count);
+
+    std::vector<PacketBuffer*> burst(70, nullptr);
+    ASSERT_TRUE(pool.allocate_bulk(burst.data(), burst.size()));
+    EXPECT_EQ(pool.get_free_count(), initial_count - 70);
+    EXPECT_EQ(pool.get_alloc_count(), 70u);
+    for (PacketBuffer* buf : burst) {
+        ASSERT_NE(buf, nullptr);
+        EXPECT_EQ(buf->ref_count(), 1);
+        EXPECT_EQ(buf->metadata()->get_state(), BufferMetadata::BufferState::Allocated);
+    }
+
+    // Only 30 left: a burst of 31 must fail without taking anything.
+    std::vector<PacketBuffer*> too_big(31, nullptr);
+    EXPECT_FALSE(pool.allocate_bulk(too_big.data(), too_big.size()));
+    EXPECT_EQ(pool.get_free_count(), initial_count - 70);
+    EXPECT_EQ(pool.get_alloc_count(), 70u);
+
+    std::vector<PacketBuffer*> rest(30, nullptr);
+    EXPECT_TRUE(pool.allocate_bulk(rest.data(), rest.size()));
+    EXPECT_EQ(pool.get_free_count(), 0u);
+
+    pool.free_bulk(burst.data(), burst.size());
+    pool.free_bulk(rest.data(), rest.size());
+    EXPECT_EQ(pool.get_free_count(), initial_count);
+    EXPECT_EQ(pool.get_dealloc_count(), initial_count);
+    EXPECT_EQ(burst[0]->metadata()->get_state(), BufferMetadata::BufferState::Free);
+}
+
+TEST_F(PacketBufferPoolTest, FreeBulkOnlyReturnsUnsharedBuffers) {
+    PacketBufferPool pool(128, 8);
+    PacketBuffer* bufs[4];
+    ASSERT_TRUE(pool.allocate_bulk(bufs, 4));
+
+    bufs[1]->add_ref();
+    bufs[2]->set_data_len(50);
+    pool.free_bulk(bufs, 4);
+
+    EXPECT_EQ(pool.get_free_count(), 8u - 1);
+    EXPECT_EQ(bufs[1]->ref_count(), 1);
+    EXPECT_EQ(bufs[2]->data_len(), 0u); // Reset like release() does
+    bufs[1]->release();
+    EXPECT_EQ(pool.get_free_count(), 8u);
+}
+
+TEST_F(PacketBufferPoolTest, BulkWithThreadCache) {
+    const size_t initial_count = 64;
+    PacketBufferPool pool(128, initial_count, -1, 64, 0, 16); // Flush threshold 24
+
+    PacketBuffer* small_burst[8];
+    ASSERT_TRUE(pool.allocate_bulk(small_burst, 8)); // Served via the cache
+    std::vector<PacketBuffer*> big_burst(initial_count - 8, nullptr);
+    ASSERT_TRUE(pool.allocate_bulk(big_burst.data(), big_burst.size())); // Bypasses the cache
+    EXPECT_EQ(pool.get_free_count(), 0u);
+
+    PacketBuffer* none[1];
+    EXPECT_FALSE(pool.allocate_bulk(none, 1));
+
+    pool.free_bulk(small_burst, 8);
+    pool.free_bulk(big_burst.data(), big_burst.size());
+    EXPECT_EQ(pool.get_free_count(), initial_count);
+
+    pool.flush_thread_cache();
+    std::vector<PacketBuffer*> all(initial_count, nullptr);
+    ASSERT_TRUE(pool.allocate_bulk(all.data(), all.size()));
+    std::sort(all.begin(), all.end());
+    EXPECT_EQ(std::adjacent_find(all.begin(), all.end()), all.end());
+    pool.free_bulk(all.data(), all.size());
+}
+
+TEST_F(PacketBufferPoolTest, SlabLayoutIsCacheLineAligned) {
+    const size_t line = PacketBufferPool::kCacheLineSize;
+    // Odd payload/headroom/tailroom sizes to make sure padding, not luck, does the aligning.
+    const size_t payload_sizes[] = {1, 60, 128, 1500, 2048, 9000};
+    const size_t headrooms[] = {0, 64, 100};
+    for (size_t payload : payload_sizes) {
+        for (size_t headroom : headrooms) {
+            const size_t count = 17;
+            PacketBufferPool pool(payload, count, -1, headroom, 7);
+            SCOPED_TRACE("payload " + std::to_string(payload) + ", headroom " + std::to_string(headroom));
+
+            const size_t unit = pool.single_buffer_unit_alloc_size_;
+            ASSERT_EQ(unit % line, 0u);
+            ASSERT_EQ(reinterpret_cast<uintptr_t>(pool.pool_memory_block_) % line, 0u);
+            ASSERT_EQ(pool.get_total_count(), count);
+
+            for (size_t i = 0; i < count; ++i) {
+                const PacketBuffer* buf = pool.buffers_[i];
+                const unsigned char* unit_start = pool.pool_memory_block_ + i * unit;
+                const unsigned char* unit_end = unit_start + unit;
+
+                EXPECT_EQ(reinterpret_cast<uintptr_t>(buf->buffer_start_) % line, 0u) << "buffer " << i;
+                EXPECT_EQ(buf->buffer_start_ + headroom, buf->data());
+
+                // Bookkeeping and data area both stay inside this buffer's own unit.
+                const unsigned char* obj = reinterpret_cast<const unsigned char*>(buf);
+                const unsigned char* meta = reinterpret_cast<const unsigned char*>(buf->metadata_);
+                EXPECT_GE(meta, unit_start);
+                EXPECT_LE(obj + sizeof(PacketBuffer), buf->buffer_start_);
+                EXPECT_LE(buf->buffer_start_ + headroom + payload + 7, unit_end);
+            }
+        }
+    }
+}
+
+namespace {
+
+// Polls until pred() holds or a generous deadline passes; growth happens on another thread.
+template <typename Pred>
+bool wait_until(Pred pred) {
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    while (!pred()) {
+        if (std::chrono::steady_clock::now() > deadline) {
+            return false;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    return true;
+}
+
+} // namespace
+
+TEST_F(PacketBufferPoolTest, ExpandPoolIsCappedAtMaxCount) {
+    PoolGrowthPolicy growth;
+    growth.max_count = 10;
+    growth.growth_step = 4;
+    growth.low_watermark = 0;
+    PacketBufferPool pool(256, 4, -1, 64, 0, 0, MemoryBacking::Default, growth);
+    EXPECT_EQ(pool.get_total_count(), 4u);
+    EXPECT_EQ(pool.get_max_count(), 10u);
+
+    EXPECT_TRUE(pool.expand_pool(4));
+    EXPECT_TRUE(pool.expand_pool(4)); // Only 2 more fit
+    EXPECT_EQ(pool.get_total_count(), 10u);
+    EXPECT_FALSE(pool.expand_pool(1));
+    EXPECT_EQ(pool.get_free_count(), 10u);
+
+    // Every buffer, grown or not, is distinct, cache-line aligned and returns home.
+    std::vector<PacketBuffer*> held;
+    while (PacketBuffer* buf = pool.allocate_buffer()) {
+        EXPECT_EQ(reinterpret_cast<uintptr_t>(buf->buffer_start_) % PacketBufferPool::kCacheLineSize, 0u);
+        EXPECT_EQ(buf->get_owning_pool(), &pool);
+        held.push_back(buf);
+    }
+    ASSERT_EQ(held.size(), 10u);
+    std::sort(held.begin(), held.end());
+    EXPECT_EQ(std::adjacent_find(held.begin(), held.end()), held.end());
+    for (PacketBuffer* buf : held) {
+        buf->release();
+    }
+    EXPECT_EQ(pool.get_free_count(), 10u);
+}
+
+TEST_F(PacketBufferPoolTest, GrowsInBackgroundBelowLowWatermark) {
+    PoolGrowthPolicy growth;
+    growth.max_count = 16;
+    growth.growth_step = 4;
+    growth.low_watermark = 1;
+    PacketBufferPool pool(512, 4, -1, 64, 0, 0, MemoryBacking::Default, growth);
+
+    std::vector<PacketBuffer*> held;
+    for (int i = 0; i < 3; ++i) { // Leaves 1 free: at the watermark
+        held.push_back(pool.allocate_buffer());
+        ASSERT_NE(held.back(), nullptr);
+    }
+    EXPECT_TRUE(wait_until([&pool]() { return pool.get_total_count() == 8; }));
+    EXPECT_EQ(pool.get_free_count(), 5u);
+
+    // Draining the pool completely keeps it growing until max_count.
+    while (pool.get_total_count() < pool.get_max_count()) {
+        PacketBuffer* buf = pool.allocate_buffer();
+        if (buf) {
+            held.push_back(buf);
+        } else {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    }
+    EXPECT_EQ(pool.get_total_count(), 16u);
+    while (PacketBuffer* buf = pool.allocate_buffer()) {
+        held.push_back(buf);
+    }
+    EXPECT_EQ(held.size(), 16u);
+    EXPECT_GE(pool.get_memory_footprint(), 16 * pool.single_buffer_unit_alloc_size_);
+
+    pool.free_bulk(held.data(), held.size());
+    EXPECT_EQ(pool.get_free_count(), 16u);
+}
+
+TEST_F(PacketBufferPoolTest, ExhaustionWithThreadCacheTriggersGrowth) {
+    PoolGrowthPolicy growth;
+    growth.max_count = 64;
+    growth.growth_step = 32;
+    PacketBufferPool pool(128, 32, -1, 64, 0, 8, MemoryBacking::Default, growth);
+
+    // One at a time through the cache: every refill before the last still sees free
+    // buffers above the watermark, so only the allocation that comes up empty asks for growth
+    // (a single allocate_bulk() of all 32 would ask already, racing the check below).
+    std::vector<PacketBuffer*> held(32);
+    for (PacketBuffer*& buf : held) {
+        buf = pool.allocate_buffer();
+        ASSERT_NE(buf, nullptr);
+    }
+    EXPECT_EQ(pool.allocate_buffer(), nullptr); // Came up empty: growth requested
+
+    EXPECT_TRUE(wait_until([&pool]() { return pool.get_total_count() == 64; }));
+    PacketBuffer* grown = pool.allocate_buffer();
+    ASSERT_NE(grown, nullptr);
+    EXPECT_GE(grown->pool_index_, 32u);
+    grown->release();
+    pool.free_bulk(held.data(), held.size());
+    pool.flush_thread_cache();
+    EXPECT_EQ(pool.get_free_count(), 64u);
+}
+
+TEST_F(PacketBufferPoolTest, IdleRegionsAreReturnedAndRevived) {
+    PoolShrinkPolicy shrink;
+    shrink.idle_period = std::chrono::milliseconds(20);
+    shrink.region_bytes = 16 * 4096;
+    const size_t count = 128;
+    PacketBufferPool pool(4000, count, -1, 64, 0, 0, MemoryBacking::Default, PoolGrowthPolicy(), shrink);
+    EXPECT_EQ(pool.get_released_bytes(), 0u);
+
+    // Idle pool: everything but a couple of regions' worth is parked.
+    ASSERT_TRUE(wait_until([&pool]() { return pool.get_released_buffer_count() > count / 2; }));
+    EXPECT_GT(pool.get_released_bytes(), 0u);
+    EXPECT_GE(pool.get_total_bytes_returned(), pool.get_released_bytes());
+    EXPECT_EQ(pool.get_free_count(), count - pool.get_released_buffer_count());
+
+    // Taking every buffer revives the parked regions; allocations that find the list empty
+    // before a revival simply retry here.
+    std::vector<PacketBuffer*> held;
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    while (held.size() < count && std::chrono::steady_clock::now() < deadline) {
+        if (PacketBuffer* buf = pool.allocate_buffer()) {
+            std::memset(buf->data(), 0x5A, 4000); // Refaults released data pages
+            held.push_back(buf);
+        } else {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    }
+    ASSERT_EQ(held.size(), count);
+    EXPECT_EQ(pool.get_released_buffer_count(), 0u);
+    EXPECT_EQ(pool.get_released_bytes(), 0u);
+    std::sort(held.begin(), held.end());
+    EXPECT_EQ(std::adjacent_find(held.begin(), held.end()), held.end());
+    for (PacketBuffer* buf : held) {
+        EXPECT_EQ(buf->ref_count(), 1);
+        EXPECT_EQ(buf->get_owning_pool(), &pool);
+    }
+    const size_t returned_before = pool.get_total_bytes_returned();
+    pool.free_bulk(held.data(), held.size());
+
+    // Idle again: shrinks again, and the cumulative counter keeps growing.
+    ASSERT_TRUE(wait_until([&]() { return pool.get_total_bytes_returned() > returned_before; }));
+}
+
+TEST_F(PacketBufferPoolTest, BusyRegionsAreNotReleased) {
+    PoolShrinkPolicy shrink;
+    shrink.idle_period = std::chrono::milliseconds(10);
+    shrink.region_bytes = 4096;
+    PacketBufferPool pool(4000, 16, -1, 64, 0, 0, MemoryBacking::Default, PoolGrowthPolicy(), shrink);
+
+    std::vector<PacketBuffer*> held(16);
+    ASSERT_TRUE(pool.allocate_bulk(held.data(), held.size()));
+    std::this_thread::sleep_for(std::chrono::milliseconds(60));
+    EXPECT_EQ(pool.get_released_bytes(), 0u);
+    EXPECT_EQ(pool.get_released_buffer_count(), 0u);
+    pool.free_bulk(held.data(), held.size());
+}
+
+TEST_F(PacketBufferPoolTest, AllocatorsKeepRunningWhileRegionsAreParked) {
+    PoolShrinkPolicy shrink;
+    shrink.idle_period = std::chrono::milliseconds(2);
+    shrink.region_bytes = 4096;
+    PoolGrowthPolicy growth;
+    growth.low_watermark = 16; // Parking leaves at least this many buffers on the list
+    PacketBufferPool pool(4000, 256, -1, 64, 0, 0, MemoryBacking::Default, growth, shrink);
+
+    // The allocator only ever holds a few buffers, so most regions go idle and get parked
+    // under it; it must neither fail nor be handed a buffer from a parked region.
+    std::vector<PacketBuffer*> held(8);
+    size_t failures = 0;
+    const auto end = std::chrono::steady_clock::now() + std::chrono::milliseconds(200);
+    while (std::chrono::steady_clock::now() < end) {
+        if (!pool.allocate_bulk(held.data(), held.size())) {
+            ++failures;
+            continue;
+        }
+        for (PacketBuffer* buf : held) {
+            ASSERT_EQ(buf->get_owning_pool(), &pool);
+            ASSERT_EQ(buf->ref_count(), 1);
+            buf->data()[0] = 1;
+        }
+        pool.free_bulk(held.data(), held.size());
+    }
+    EXPECT_EQ(failures, 0u);
+    EXPECT_GT(pool.get_total_bytes_returned(), 0u);
+}
+
+TEST_F(PacketBufferPoolTest, ForeignFreesAreReturnedInBatches) {
+    // A node this thread is not running on; it need not be online for the pool to work.
+    const int foreign_node = NumaTopology::current_node() + 1;
+    PoolRemoteFreePolicy remote;
+    remote.batch_size = 8;
+    PacketBufferPool pool(256, 32, foreign_node, 64, 0, 0, MemoryBacking::Default,
+                          PoolGrowthPolicy(), PoolShrinkPolicy(), remote);
+    ASSERT_EQ(pool.get_remote_free_batch_size(), 8u);
+    const auto& queue = pool.remote_queues_[ThreadSlot::current()];
+
+    std::vector<PacketBuffer*> held;
+    for (int i = 0; i < 20; ++i) {
+        held.push_back(pool.allocate_buffer());
+        ASSERT_NE(held.back(), nullptr);
+    }
+    for (int i = 0; i < 7; ++i) {
+        held[i]->release();
+    }
+    EXPECT_EQ(queue.len, 7u); // Staged, not yet on the shared free list
+    held[7]->release();
+    EXPECT_EQ(queue.len, 0u); // The eighth free sent the batch home
+
+    PacketBuffer* staged[3];
+    for (int i = 0; i < 3; ++i) {
+        staged[i] = held[8 + i];
+    }
+    pool.free_bulk(staged, 3);
+    EXPECT_EQ(queue.len, 3u);
+    pool.flush_thread_cache();
+    EXPECT_EQ(queue.len, 0u);
+    EXPECT_EQ(pool.get_remote_free_count(), 11u);
+
+    // Everything freed so far is allocatable again.
+    for (int i = 0; i < 23; ++i) {
+        held.push_back(pool.allocate_buffer());
+        ASSERT_NE(held.back(), nullptr) << "allocation " << i;
+    }
+    EXPECT_EQ(pool.allocate_buffer(), nullptr);
+    for (size_t i = 11; i < held.size(); ++i) {
+        held[i]->release();
+    }
+    pool.flush_thread_cache();
+    EXPECT_EQ(pool.get_free_count(), 32u);
+}
+
+TEST_F(PacketBufferPoolTest, LocalFreesBypassTheRemoteQueue) {
+    PoolRemoteFreePolicy remote;
+    remote.batch_size = 8;
+    PacketBufferPool local(256, 32, NumaTopology::current_node(), 64, 0, 0, MemoryBacking::Default,
+                           PoolGrowthPolicy(), PoolShrinkPolicy(), remote);
+    PacketBuffer* buf = local.allocate_buffer();
+    ASSERT_NE(buf, nullptr);
+    buf->release();
+    EXPECT_EQ(local.remote_queues_[ThreadSlot::current()].len, 0u);
+    EXPECT_EQ(local.get_remote_free_count(), 0u);
+
+    PacketBufferPool global(256, 32, -1, 64, 0, 0, MemoryBacking::Default,
+                            PoolGrowthPolicy(), PoolShrinkPolicy(), remote);
+    EXPECT_EQ(global.get_remote_free_batch_size(), 0u); // No home node, so no foreign threads
+}
+
+TEST_F(PacketBufferPoolTest, HandlesRoundTripToBuffers) {
+    PacketBufferPool pool(256, 16);
+    PacketBufferPool other(256, 16);
+    ASSERT_TRUE(pool.has_handles());
+    ASSERT_TRUE(other.has_handles());
+    EXPECT_NE(pool.get_handle_pool_id(), other.get_handle_pool_id());
+
+    PacketBuffer* buf = pool.allocate_buffer();
+    ASSERT_NE(buf, nullptr);
+    BufferHandle handle = pool.to_handle(buf);
+    ASSERT_TRUE(handle.valid());
+    EXPECT_EQ(handle.pool_id(), pool.get_handle_pool_id());
+    EXPECT_EQ(handle.index(), buf->pool_index_);
+    EXPECT_EQ(pool.from_handle(handle), buf);
+    EXPECT_EQ(PacketBufferPool::resolve(handle), buf);
+    EXPECT_EQ(other.from_handle(handle), nullptr); // Not other's handle
+    EXPECT_FALSE(other.to_handle(buf).valid());
+
+    EXPECT_EQ(PacketBufferPool::resolve(BufferHandle()), nullptr);
+    EXPECT_EQ(PacketBufferPool::resolve(BufferHandle::make(BufferHandle::kMaxPools, 0)), nullptr); // Reserved id
+    EXPECT_EQ(pool.from_handle(BufferHandle::make(BufferHandle::kMaxPools, 0)), nullptr);
+    EXPECT_EQ(pool.from_handle(BufferHandle::make(pool.get_handle_pool_id(), 16)), nullptr); // Out of range
+    buf->release();
+
+    // A destroyed pool's id is retired, then handed to the next pool.
+    auto temp = std::make_unique<PacketBufferPool>(64, 4);
+    const uint32_t temp_id = temp->get_handle_pool_id();
+    PacketBuffer* t = temp->allocate_buffer();
+    ASSERT_NE(t, nullptr);
+    BufferHandle temp_handle = temp->to_handle(t);
+    EXPECT_EQ(PacketBufferPool::resolve(temp_handle), t);
+    t->release();
+    temp.reset();
+    EXPECT_EQ(PacketBufferPool::resolve(temp_handle), nullptr);
+    PacketBufferPool next(64, 4);
+    EXPECT_EQ(next.get_handle_pool_id(), temp_id);
+}
+
+TEST_F(PacketBufferPoolTest, HandlesIntoParkedRegionsDoNotResolve) {
+    PoolShrinkPolicy shrink;
+    shrink.idle_period = std::chrono::milliseconds(10);
+    shrink.region_bytes = 16 * 4096;
+    const size_t count = 128;
+    PacketBufferPool pool(4000, count, -1, 0, 0, 0, MemoryBacking::Default, PoolGrowthPolicy(), shrink);
+    ASSERT_TRUE(pool.has_handles());
+    ASSERT_TRUE(wait_until([&pool]() { return pool.get_released_buffer_count() > count / 2; }));
+
+    // Nothing is allocated, so parked regions stay parked while we look.
+    const size_t parked = pool.get_released_buffer_count();
+    size_t unresolved = 0;
+    for (uint32_t i = 0; i < count; ++i) {
+        if (!pool.from_handle(BufferHandle::make(pool.get_handle_pool_id(), i))) {
+            ++unresolved;
+        }
+    }
+    EXPECT_GE(unresolved, parked);
+    EXPECT_LT(unresolved, count);
+}
+
+TEST_F(PacketBufferPoolTest, PoolsTooLargeForHandlesIssueInvalidHandles) {
+    PoolGrowthPolicy growth;
+    growth.max_count = size_t(BufferHandle::kMaxIndex) + 2;
+    PacketBufferPool pool(64, 4, -1, 0, 0, 0, MemoryBacking::Default, growth);
+    EXPECT_FALSE(pool.has_handles());
+    PacketBuffer* buf = pool.allocate_buffer();
+    ASSERT_NE(buf, nullptr);
+    EXPECT_FALSE(pool.to_handle(buf).valid());
+    // Its handle_pool_id_ is the reserved id: handles carrying that id must still not decode.
+    EXPECT_EQ(pool.from_handle(BufferHandle::make(BufferHandle::kMaxPools, buf->pool_index_)), nullptr);
+    EXPECT_EQ(pool.from_handle(BufferHandle()), nullptr);
+    buf->release();
+}
+
+TEST_F(PacketBufferPoolTest, ClonesViewTheOriginalAndPinIt) {
+    PacketBufferPool data_pool(1500, 2, -1, 128, 0);
+    PacketBufferPool clone_pool(0, 4, -1, 0, 0); // Clones need no data area of their own
+
+    PacketBuffer* orig = data_pool.allocate_buffer();
+    ASSERT_NE(orig, nullptr);
+    orig->set_data_len(100);
+    orig->data()[0] = 0xAB;
+    orig->metadata()->set_vlan_id(10);
+
+    PacketBuffer* a = orig->clone(clone_pool);
+    ASSERT_NE(a, nullptr);
+    EXPECT_TRUE(a->is_clone());
+    EXPECT_FALSE(orig->is_clone());
+    EXPECT_EQ(a->direct_buffer(), orig);
+    EXPECT_EQ(a->data(), orig->data()); // Same bytes, nothing copied
+    EXPECT_EQ(a->data_len(), 100u);
+    EXPECT_EQ(a->get_owning_pool(), &clone_pool);
+    EXPECT_EQ(orig->ref_count(), 2);
+
+    // Metadata is a copy the clone may rewrite; the shared bytes around the view are not its to use.
+    EXPECT_NE(a->metadata(), orig->metadata());
+    EXPECT_EQ(a->metadata()->get_vlan_id(), 10);
+    a->metadata()->set_vlan_id(20);
+    EXPECT_EQ(orig->metadata()->get_vlan_id(), 10);
+    EXPECT_EQ(a->reserve_headroom(1), nullptr);
+    EXPECT_EQ(a->reserve_tailroom(1), nullptr);
+
+    // A clone of a clone points at the original directly.
+    a->set_data_len(60);
+    PacketBuffer* b = a->clone(clone_pool);
+    ASSERT_NE(b, nullptr);
+    EXPECT_EQ(b->direct_buffer(), orig);
+    EXPECT_EQ(b->data_len(), 60u);
+    EXPECT_EQ(orig->ref_count(), 3);
+
+    // The original outlives its own release until the last clone lets go.
+    orig->release();
+    EXPECT_EQ(data_pool.get_free_count(), 1u);
+    a->release();
+    EXPECT_EQ(orig->ref_count(), 1);
+    EXPECT_EQ(b->data()[0], 0xAB);
+    b->release();
+    EXPECT_EQ(data_pool.get_free_count(), 2u);
+    EXPECT_EQ(clone_pool.get_free_count(), 4u);
+    // Freed clones sit on the free list in the same state as any other free buffer.
+    EXPECT_EQ(a->metadata()->get_state(), BufferMetadata::BufferState::Free);
+    EXPECT_EQ(b->metadata()->get_state(), BufferMetadata::BufferState::Free);
+    EXPECT_EQ(orig->metadata()->get_state(), BufferMetadata::BufferState::Free);
+
+    // Freed clones get their own (empty) data area back.
+    PacketBuffer* reused = clone_pool.allocate_buffer();
+    ASSERT_NE(reused, nullptr);
+    EXPECT_FALSE(reused->is_clone());
+    EXPECT_EQ(reused->data_len(), 0u);
+    EXPECT_EQ(reused->capacity(), 0u);
+    reused->release();
+}
+
+TEST_F(PacketBufferPoolTest, FreeBulkReleasesWhatClonesPin) {
+    PacketBufferPool data_pool(256, 1, -1, 0, 0);
+    PacketBufferPool clone_pool(0, 8, -1, 0, 0);
+
+    PacketBuffer* orig = data_pool.allocate_buffer();
+    ASSERT_NE(orig, nullptr);
+    orig->set_data_len(64);
+    PacketBuffer* clones[8];
+    for (PacketBuffer*& c : clones) {
+        c = orig->clone(clone_pool);
+        ASSERT_NE(c, nullptr);
+    }
+    EXPECT_EQ(orig->clone(clone_pool), nullptr); // Clone pool exhausted
+    EXPECT_EQ(orig->ref_count(), 9);
+
+    orig->release();
+    clone_pool.free_bulk(clones, 8);
+    EXPECT_EQ(clone_pool.get_free_count(), 8u);
+    EXPECT_EQ(data_pool.get_free_count(), 1u);
+    for (PacketBuffer* c : clones) {
+        EXPECT_EQ(c->metadata()->get_state(), BufferMetadata::BufferState::Free);
+    }
+}
+
+TEST_F(PacketBufferPoolTest, JumboFrameChainsFromStandardBuffers) {
+    PacketBufferPool pool(2048, 8, -1, 0, 0);
+    const size_t kJumbo = 9000;
+
+    PacketBuffer* segs[5];
+    ASSERT_TRUE(pool.allocate_bulk(segs, 5));
+    PacketBuffer* pkt = segs[0];
+    size_t remaining = kJumbo;
+    for (PacketBuffer* seg : segs) {
+        seg->set_data_len(remaining);
+        remaining -= seg->data_len();
+        if (seg != pkt) {
+            pkt->append_segment(seg);
+        }
+    }
+    EXPECT_EQ(remaining, 0u);
+    EXPECT_EQ(pkt->nb_segs(), 5u);
+    EXPECT_EQ(pkt->pkt_len(), kJumbo);
+    EXPECT_EQ(pkt->last_segment(), segs[4]);
+    EXPECT_EQ(segs[4]->data_len(), kJumbo - 4 * 2048);
+
+    size_t i = 0;
+    for (PacketBuffer* seg : pkt->segments()) {
+        EXPECT_EQ(seg, segs[i++]);
+    }
+    EXPECT_EQ(i, 5u);
+
+    // Appending a chain splices all of it in.
+    PacketBuffer* extra[2];
+    ASSERT_TRUE(pool.allocate_bulk(extra, 2));
+    extra[0]->set_data_len(10);
+    extra[1]->set_data_len(20);
+    extra[0]->append_segment(extra[1]);
+    pkt->append_segment(extra[0]);
+    EXPECT_EQ(pkt->nb_segs(), 7u);
+    EXPECT_EQ(pkt->pkt_len(), kJumbo + 30);
+
+    // A segment still referenced elsewhere survives the chain's release.
+    segs[2]->add_ref();
+    pkt->release_chain();
+    EXPECT_EQ(pool.get_free_count(), 7u);
+    EXPECT_EQ(segs[2]->ref_count(), 1);
+    EXPECT_EQ(segs[2]->next_buffer(), segs[3]); // Untouched until its own release
+    segs[2]->release();
+    EXPECT_EQ(pool.get_free_count(), 8u);
+}
+
+TEST_F(PacketBufferPoolTest, ReleaseChainSendsForeignSegmentsHome) {
+    PacketBufferPool small(128, 2, -1, 0, 0);
+    PacketBufferPool large(2048, 2, -1, 0, 0);
+    PacketBuffer* header = small.allocate_buffer();
+    PacketBuffer* body = large.allocate_buffer();
+    ASSERT_NE(header, nullptr);
+    ASSERT_NE(body, nullptr);
+    header->set_data_len(14);
+    body->set_data_len(1000);
+    header->append_segment(body);
+    EXPECT_EQ(header->pkt_len(), 1014u);
+    EXPECT_EQ(body->nb_segs(), 1u);
+
+    header->release_chain();
+    EXPECT_EQ(small.get_free_count(), 2u);
+    EXPECT_EQ(large.get_free_count(), 2u);
+}
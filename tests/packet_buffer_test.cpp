@@ -2,7 +2,10 @@
 #include "packet_buffer.hpp"
 #include "packet_buffer_pool.hpp" // For PacketBufferPool base class
 #include "buffer_metadata.hpp"
+#include <atomic>
 #include <memory> // For std::make_shared
+#include <thread>
+#include <vector>
 
 // Dummy pool for testing PacketBuffer release behavior.
 class DummyPacketBufferPoolForTest : public PacketBufferPool {
@@ -223,3 +226,62 @@ TEST(PacketBufferTest, ResetDataPtrFunctionality) {
     buffer->release();
     delete[] raw_mem;
 }
+
+TEST(PacketBufferTest, SoleOwnerReleaseAndReleaseUnshared) {
+    auto dummy_pool = std::make_shared<DummyPacketBufferPoolForTest>(128, 1, 16);
+    size_t unit_size = sizeof(BufferMetadata) + sizeof(PacketBuffer) + 16 + 128;
+    unsigned char* raw_mem = new unsigned char[unit_size];
+    PacketBuffer* buffer = create_simulated_pb(dummy_pool.get(), raw_mem, unit_size, 128, 16, 0);
+
+    buffer->add_ref(); // As the pool would on allocation
+    buffer->set_data_len(40);
+    buffer->release(); // Count 1: no RMW, straight back to the pool
+    EXPECT_EQ(buffer->ref_count(), 0);
+    EXPECT_EQ(dummy_pool->deallocated_count, 1);
+    EXPECT_EQ(buffer->data_len(), 0u);
+
+    buffer->add_ref();
+    buffer->set_data_len(40);
+    buffer->release_unshared();
+    EXPECT_EQ(buffer->ref_count(), 0);
+    EXPECT_EQ(dummy_pool->deallocated_count, 2);
+    EXPECT_EQ(buffer->data_len(), 0u);
+
+    buffer->metadata()->~BufferMetadata();
+    buffer->~PacketBuffer();
+    delete[] raw_mem;
+}
+
+TEST(PacketBufferTest, ConcurrentReleasesReturnTheBufferOnce) {
+    auto dummy_pool = std::make_shared<DummyPacketBufferPoolForTest>(128, 1, 0);
+    size_t unit_size = sizeof(BufferMetadata) + sizeof(PacketBuffer) + 128;
+    unsigned char* raw_mem = new unsigned char[unit_size];
+    PacketBuffer* buffer = create_simulated_pb(dummy_pool.get(), raw_mem, unit_size, 128, 0, 0);
+
+    const int kOwners = 8;
+    for (int round = 0; round < 200; ++round) {
+        for (int i = 0; i < kOwners; ++i) {
+            buffer->add_ref();
+        }
+        std::atomic<bool> go{false};
+        std::vector<std::thread> owners;
+        for (int i = 0; i < kOwners; ++i) {
+            owners.emplace_back([&]() {
+                while (!go.load()) {
+                    std::this_thread::yield();
+                }
+                buffer->release();
+            });
+        }
+        go = true;
+        for (auto& th : owners) {
+            th.join();
+        }
+        ASSERT_EQ(buffer->ref_count(), 0);
+        ASSERT_EQ(dummy_pool->deallocated_count, round + 1);
+    }
+
+    buffer->metadata()->~BufferMetadata();
+    buffer->~PacketBuffer();
+    delete[] raw_mem;
+}
@@ -2,6 +2,12 @@
 #include "pool_manager.hpp"
 #include "packet_buffer.hpp"    // For PacketBuffer
 #include "buffer_metadata.hpp"  // For BufferMetadata (indirectly via PacketBuffer)
+#include "numa_topology.hpp"
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <stdexcept> // For std::invalid_argument
+#include <thread>
 #include <vector>
 
 // To properly test PoolManager's effect on pool stats, we might need to inspect pools.
@@ -169,3 +175,302 @@ TEST(PoolManagerTest, FallbackToGlobalPool) {
         buf->release();
     }
 }
+
+TEST(PoolManagerTest, BulkAllocateAndFree) {
+    PoolManager& pm = PoolManager::instance();
+    int test_numa_node = 4;
+    ASSERT_TRUE(pm.add_pool(test_numa_node, {256, 40, 64, 0}));
+    ASSERT_TRUE(pm.add_pool(test_numa_node, {2048, 8, 64, 0}));
+
+    PacketBuffer* small[32];
+    ASSERT_TRUE(pm.allocate_bulk(small, 32, 200, test_numa_node));
+    for (PacketBuffer* buf : small) {
+        ASSERT_NE(buf, nullptr);
+        EXPECT_GE(buf->capacity(), 256u);
+        EXPECT_EQ(buf->get_numa_node(), test_numa_node);
+    }
+
+    // All-or-nothing: 9 more than the 8 left must fail and leave the 8 in place.
+    PacketBuffer* overflow[9];
+    EXPECT_FALSE(pm.allocate_bulk(overflow, 9, 200, test_numa_node));
+    PacketBuffer* remaining[8];
+    ASSERT_TRUE(pm.allocate_bulk(remaining, 8, 200, test_numa_node));
+
+    PacketBuffer* large[2];
+    ASSERT_TRUE(pm.allocate_bulk(large, 2, 1500, test_numa_node));
+
+    // Mixed-pool burst back in one call.
+    std::vector<PacketBuffer*> mixed(small, small + 32);
+    mixed.insert(mixed.begin() + 5, large[0]);
+    mixed.push_back(large[1]);
+    mixed.insert(mixed.end(), remaining, remaining + 8);
+    pm.free_bulk(mixed.data(), mixed.size());
+
+    PacketBufferPool* small_pool = small[0]->get_owning_pool();
+    PacketBufferPool* large_pool = large[0]->get_owning_pool();
+    EXPECT_EQ(small_pool->get_free_count(), 40u);
+    EXPECT_EQ(large_pool->get_free_count(), 8u);
+
+    EXPECT_FALSE(pm.allocate_bulk(small, 4, 100000, test_numa_node)); // No pool that large
+}
+
+TEST(PoolManagerTest, CurrentNodeAllocationUsesLocalNodeThenFallbackOrder) {
+    PoolManager& pm = PoolManager::instance();
+    const int local_node = NumaTopology::current_node();
+    const int far_node = 6; // Need not exist: pools on absent nodes still work, unbound
+
+    ASSERT_TRUE(pm.add_pool(local_node, {4096, 2, 64, 0}));
+    ASSERT_TRUE(pm.add_pool(far_node, {4096, 1, 64, 0}));
+    pm.set_numa_fallback_order(local_node, {local_node, far_node});
+
+    PacketBuffer* a = pm.allocate(3000, PoolManager::kCurrentNode);
+    PacketBuffer* b = pm.allocate(3000, PoolManager::kCurrentNode);
+    PacketBuffer* c = pm.allocate(3000, PoolManager::kCurrentNode); // Local pool now empty
+    ASSERT_NE(a, nullptr);
+    ASSERT_NE(b, nullptr);
+    ASSERT_NE(c, nullptr);
+    EXPECT_EQ(a->get_numa_node(), local_node);
+    EXPECT_EQ(b->get_numa_node(), local_node);
+    EXPECT_EQ(c->get_numa_node(), far_node);
+
+    EXPECT_EQ(pm.allocate(3000, PoolManager::kCurrentNode), nullptr); // Everything exhausted
+
+    c->release();
+    PacketBuffer* burst[1];
+    ASSERT_TRUE(pm.allocate_bulk(burst, 1, 3000, PoolManager::kCurrentNode));
+    EXPECT_EQ(burst[0]->get_numa_node(), far_node);
+    burst[0]->release();
+
+    pm.set_numa_fallback_order(local_node, {}); // Back to distance order: far_node not online
+    EXPECT_EQ(pm.allocate(3000, PoolManager::kCurrentNode), nullptr);
+
+    a->release();
+    b->release();
+}
+
+TEST(PoolManagerTest, NumaTopologyDescribesThisHost) {
+    const std::vector<int>& nodes = NumaTopology::online_nodes();
+    ASSERT_FALSE(nodes.empty());
+    const int here = NumaTopology::current_node();
+    EXPECT_TRUE(NumaTopology::is_online(here));
+
+    std::vector<int> order = NumaTopology::nodes_by_distance(here);
+    ASSERT_EQ(order.size(), nodes.size());
+    EXPECT_EQ(order.front(), here);
+    EXPECT_TRUE(NumaTopology::nodes_by_distance(100000).empty());
+}
+
+TEST(PoolManagerTest, SizeClassLookupPicksSmallestFittingPoolForOddSizes) {
+    PoolManager& pm = PoolManager::instance();
+    const int node = 7;
+    // Several pools inside one 64-byte lookup bucket, and sizes off the bucket grid.
+    ASSERT_TRUE(pm.configure_pools_for_numa_node(node, {{100, 2, 0, 0}, {110, 2, 0, 0},
+                                                        {120, 2, 0, 0}, {1500, 2, 0, 0}}));
+
+    struct Case { size_t request; size_t expected_capacity; };
+    const Case cases[] = {{0, 100}, {1, 100}, {100, 100}, {101, 110}, {110, 110},
+                          {111, 120}, {120, 120}, {121, 1500}, {128, 1500}, {1500, 1500}};
+    for (const Case& c : cases) {
+        PacketBuffer* buf = pm.allocate(c.request, node);
+        ASSERT_NE(buf, nullptr) << "request " << c.request;
+        EXPECT_EQ(buf->capacity(), c.expected_capacity) << "request " << c.request;
+        EXPECT_EQ(buf->get_numa_node(), node);
+        buf->release();
+    }
+    // The global (-1) pools other tests configure stop at 1024 bytes.
+    PacketBuffer* too_large = pm.allocate(1501, node);
+    EXPECT_EQ(too_large, nullptr) << "No pool on node or globally";
+    if (too_large) {
+        too_large->release();
+    }
+
+    // A node without pools of its own, even one no pool can be added for, falls back to
+    // the global pools. add_pool() is a no-op if an earlier test already made this one.
+    ASSERT_TRUE(pm.add_pool(-1, {128, 5, 32, 0}));
+    PacketBuffer* fallback = pm.allocate(100, -5);
+    ASSERT_NE(fallback, nullptr);
+    EXPECT_EQ(fallback->get_numa_node(), -1);
+    fallback->release();
+}
+
+TEST(PoolManagerTest, PoolsCannotBeAddedForUnaddressableNodes) {
+    PoolManager& pm = PoolManager::instance();
+    EXPECT_THROW(pm.add_pool(PoolManager::kCurrentNode, {128, 2, 0, 0}), std::invalid_argument);
+    EXPECT_THROW(pm.configure_pools_for_numa_node(-5, {{128, 2, 0, 0}}), std::invalid_argument);
+}
+
+TEST(PoolManagerTest, AllocationProceedsWhilePoolsAreAdded) {
+    PoolManager& pm = PoolManager::instance();
+    const int node = 8;
+    ASSERT_TRUE(pm.add_pool(node, {256, 64, 64, 0}));
+
+    std::atomic<bool> stop{false};
+    std::atomic<size_t> failures{0};
+    std::thread reader([&]() {
+        while (!stop.load()) {
+            PacketBuffer* buf = pm.allocate(200, node);
+            if (!buf) {
+                failures++;
+                continue;
+            }
+            buf->release();
+        }
+    });
+    for (size_t size = 512; size < 512 + 64 * 50; size += 64) {
+        ASSERT_TRUE(pm.add_pool(node, {size, 1, 0, 0}));
+    }
+    stop = true;
+    reader.join();
+    EXPECT_EQ(failures.load(), 0u);
+
+    PacketBuffer* buf = pm.allocate(512 + 64 * 49, node);
+    ASSERT_NE(buf, nullptr);
+    buf->release();
+}
+
+TEST(PoolManagerTest, StatisticsSnapshotCoversEveryPool) {
+    PoolManager& pm = PoolManager::instance();
+    const int node = 10;
+    PoolConfig cached{512, 32, 64, 0};
+    cached.per_thread_cache_size = 8;
+    ASSERT_TRUE(pm.add_pool(node, cached));
+    ASSERT_TRUE(pm.add_pool(node, {2048, 4, 64, 0}));
+
+    std::vector<PacketBuffer*> held;
+    for (int i = 0; i < 4; ++i) {
+        held.push_back(pm.allocate(2048, node));
+        ASSERT_NE(held.back(), nullptr);
+    }
+    EXPECT_EQ(pm.allocate(2048, node), nullptr); // One failure
+    for (int i = 0; i < 16; ++i) {
+        PacketBuffer* buf = pm.allocate(500, node);
+        ASSERT_NE(buf, nullptr);
+        buf->release();
+    }
+
+    std::vector<PoolStatistics> pools;
+    PoolManagerStatistics stats = pm.get_statistics(pools);
+    ASSERT_FALSE(stats.truncated());
+    ASSERT_EQ(stats.pools_filled, stats.pool_count);
+    EXPECT_EQ(stats.pool_count, pm.get_pool_count());
+    EXPECT_EQ(stats.pools, pools.data());
+
+    PoolStatistics first;
+    PoolManagerStatistics partial = pm.get_statistics(&first, 1);
+    EXPECT_TRUE(partial.truncated()); // Node 10 alone has two pools
+    EXPECT_EQ(partial.pools_filled, 1u);
+    EXPECT_EQ(partial.pool_count, stats.pool_count);
+    const PoolStatistics* small = nullptr;
+    const PoolStatistics* large = nullptr;
+    for (size_t i = 0; i < stats.pool_count; ++i) {
+        if (i > 0) {
+            EXPECT_GE(stats.pools[i].numa_node, stats.pools[i - 1].numa_node);
+        }
+        if (stats.pools[i].numa_node == node && stats.pools[i].payload_size == 512) {
+            small = &stats.pools[i];
+        } else if (stats.pools[i].numa_node == node && stats.pools[i].payload_size == 2048) {
+            large = &stats.pools[i];
+        }
+    }
+    ASSERT_NE(small, nullptr);
+    ASSERT_NE(large, nullptr);
+
+    EXPECT_EQ(large->total_count, 4u);
+    EXPECT_EQ(large->in_use_count, 4u);
+    EXPECT_EQ(large->free_count, 0u);
+    EXPECT_EQ(large->alloc_count, 4u);
+    EXPECT_EQ(large->alloc_failures, 1u);
+    EXPECT_EQ(large->high_water_mark, 4u);
+    EXPECT_EQ(large->cache_hit_rate, 0.0); // No thread cache
+
+    EXPECT_EQ(small->alloc_count, 16u);
+    EXPECT_EQ(small->free_count_total, 16u);
+    EXPECT_EQ(small->in_use_count, 0u);
+    EXPECT_EQ(small->cache_misses, 1u); // The first allocation filled the cache
+    EXPECT_EQ(small->cache_hits, 15u);
+    EXPECT_DOUBLE_EQ(small->cache_hit_rate, 15.0 / 16.0);
+    EXPECT_GE(stats.events_recorded + stats.events_suppressed, 1u);
+
+    for (PacketBuffer* buf : held) {
+        buf->release();
+    }
+}
+
+TEST(PoolManagerTest, StatisticsCallbackAlertsWithHysteresis) {
+    PoolManager& pm = PoolManager::instance();
+    const int node = 12;
+    ASSERT_TRUE(pm.add_pool(node, {128, 10, 64, 0}));
+
+    std::mutex mutex;
+    std::vector<UtilizationAlert> alerts;
+    std::atomic<int> samples{0};
+    StatisticsCallbackConfig config;
+    config.interval = std::chrono::milliseconds(5);
+    config.raise_utilization = 0.9;
+    config.clear_utilization = 0.5;
+    pm.set_statistics_callback(
+        [&](const PoolManagerStatistics&) { samples++; },
+        [&](const UtilizationAlert& alert) {
+            if (alert.numa_node == node) {
+                std::lock_guard<std::mutex> lock(mutex);
+                alerts.push_back(alert);
+            }
+        },
+        config);
+    // Declared after everything the callbacks capture, so the sampler is stopped before
+    // those go away even when an ASSERT below returns early.
+    struct SamplerGuard {
+        PoolManager& pm;
+        ~SamplerGuard() { pm.clear_statistics_callback(); }
+    } sampler_guard{pm};
+
+    auto alerts_seen = [&]() {
+        std::lock_guard<std::mutex> lock(mutex);
+        return alerts;
+    };
+    auto wait_for_samples = [&](int n) {
+        int target = samples.load() + n;
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+        while (samples.load() < target && std::chrono::steady_clock::now() < deadline) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    };
+
+    std::vector<PacketBuffer*> held;
+    for (int i = 0; i < 10; ++i) {
+        held.push_back(pm.allocate(128, node));
+        ASSERT_NE(held.back(), nullptr);
+    }
+    wait_for_samples(3);
+    std::vector<UtilizationAlert> seen = alerts_seen();
+    ASSERT_EQ(seen.size(), 1u);
+    EXPECT_TRUE(seen[0].raised);
+    EXPECT_EQ(seen[0].payload_size, 128u);
+    EXPECT_DOUBLE_EQ(seen[0].utilization, 1.0);
+
+    // 80%: below the raise threshold but above the clear one, so nothing fires.
+    held.back()->release();
+    held.pop_back();
+    held.back()->release();
+    held.pop_back();
+    wait_for_samples(3);
+    EXPECT_EQ(alerts_seen().size(), 1u);
+
+    while (held.size() > 4) {
+        held.back()->release();
+        held.pop_back();
+    }
+    wait_for_samples(3);
+    pm.clear_statistics_callback();
+    seen = alerts_seen();
+    ASSERT_EQ(seen.size(), 2u);
+    EXPECT_FALSE(seen[1].raised);
+    EXPECT_DOUBLE_EQ(seen[1].utilization, 0.4);
+
+    int after_stop = samples.load();
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    EXPECT_EQ(samples.load(), after_stop);
+    for (PacketBuffer* buf : held) {
+        buf->release();
+    }
+}
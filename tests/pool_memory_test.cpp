@@ -0,0 +1,133 @@
+#include "gtest/gtest.h"
+#include "pool_memory.hpp"
+#include "packet_buffer_pool.hpp"
+#include <cstdint>
+#include <cstring>
+#include <utility>
+
+namespace {
+
+void expect_usable(const PoolMemory& mem, size_t requested) {
+    ASSERT_NE(mem.data(), nullptr);
+    EXPECT_GE(mem.size(), requested);
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(mem.data()) % 4096, 0u);
+    // Zero-filled and writable end to end.
+    EXPECT_EQ(mem.data()[0], 0);
+    EXPECT_EQ(mem.data()[requested - 1], 0);
+    std::memset(mem.data(), 0xAB, requested);
+    EXPECT_EQ(mem.data()[requested - 1], 0xAB);
+}
+
+} // namespace
+
+TEST(PoolMemoryTest, DefaultBackingIsPlainPages) {
+    PoolMemory mem = PoolMemory::map(10000, MemoryBacking::Default);
+    expect_usable(mem, 10000);
+    EXPECT_EQ(mem.backing(), MemoryBacking::Default);
+}
+
+TEST(PoolMemoryTest, HugepageRequestsAlwaysSucceedWithSomeBacking) {
+    // Whether reserved hugepages or THP exist depends on the host, so only the fallback
+    // contract is checked: the mapping exists and its size matches the backing obtained.
+    const size_t requested = (3u << 20) + 123;
+    for (MemoryBacking want : {MemoryBacking::TransparentHugepage, MemoryBacking::Hugepage2M,
+                               MemoryBacking::Hugepage1G}) {
+        PoolMemory mem = PoolMemory::map(requested, want);
+        expect_usable(mem, requested);
+        switch (mem.backing()) {
+            case MemoryBacking::Hugepage1G:
+                EXPECT_EQ(want, MemoryBacking::Hugepage1G);
+                EXPECT_EQ(mem.size() % (1u << 30), 0u);
+                break;
+            case MemoryBacking::Hugepage2M:
+                EXPECT_NE(want, MemoryBacking::TransparentHugepage);
+                EXPECT_EQ(mem.size() % (2u << 20), 0u);
+                break;
+            case MemoryBacking::TransparentHugepage:
+                EXPECT_EQ(reinterpret_cast<uintptr_t>(mem.data()) % (2u << 20), 0u);
+                break;
+            case MemoryBacking::Default:
+                break;
+        }
+    }
+}
+
+TEST(PoolMemoryTest, MoveTransfersOwnership) {
+    PoolMemory a = PoolMemory::map(4096, MemoryBacking::Default);
+    unsigned char* base = a.data();
+    PoolMemory b = std::move(a);
+    EXPECT_EQ(a.data(), nullptr);
+    EXPECT_EQ(b.data(), base);
+    b.data()[0] = 1;
+}
+
+TEST(PoolMemoryTest, PoolReportsObtainedBacking) {
+    PacketBufferPool plain(2048, 64);
+    EXPECT_EQ(plain.get_memory_backing(), MemoryBacking::Default);
+    EXPECT_GE(plain.get_memory_footprint(), 64u * 2048);
+
+    PacketBufferPool huge(2048, 1024, -1, 64, 0, 0, MemoryBacking::Hugepage2M);
+    EXPECT_NE(memory_backing_name(huge.get_memory_backing()), nullptr);
+    PacketBuffer* buf = huge.allocate_buffer();
+    ASSERT_NE(buf, nullptr);
+    std::memset(buf->data(), 0x5A, buf->capacity());
+    buf->release();
+}
+
+TEST(PoolMemoryTest, BindsToOnlineNodeAndReportsPagePlacement) {
+    // Node 0 exists on every Linux box, NUMA or not.
+    PoolMemory mem = PoolMemory::map(64 * 4096 + 1, MemoryBacking::Default, 0);
+    ASSERT_NE(mem.data(), nullptr);
+    EXPECT_EQ(mem.bound_node(), 0);
+
+    std::vector<int> nodes = mem.page_nodes();
+    ASSERT_EQ(nodes.size(), mem.size() / mem.page_size());
+    for (size_t i = 0; i < nodes.size(); ++i) {
+        EXPECT_EQ(nodes[i], 0) << "page " << i; // Pre-faulted, so every page is resident
+    }
+}
+
+TEST(PoolMemoryTest, UnknownNodeFallsBackToUnboundMemory) {
+    PoolMemory mem = PoolMemory::map(16 * 4096, MemoryBacking::Default, 1000);
+    ASSERT_NE(mem.data(), nullptr);
+    EXPECT_EQ(mem.bound_node(), -1);
+    for (int node : mem.page_nodes()) {
+        EXPECT_GE(node, 0); // Still pre-faulted, on whatever node first touch picked
+    }
+
+    PoolMemory unplaced = PoolMemory::map(4096, MemoryBacking::Default);
+    EXPECT_EQ(unplaced.bound_node(), -1);
+}
+
+TEST(PoolMemoryTest, PoolSlabIsPlacedOnItsNode) {
+    PacketBufferPool pool(2048, 256, 0);
+    EXPECT_TRUE(pool.is_numa_bound());
+    std::vector<int> nodes = pool.get_page_numa_nodes();
+    ASSERT_FALSE(nodes.empty());
+    for (int node : nodes) {
+        EXPECT_EQ(node, 0);
+    }
+
+    PacketBufferPool global_pool(2048, 16, -1);
+    EXPECT_FALSE(global_pool.is_numa_bound());
+}
+
+TEST(PoolMemoryTest, ReleaseReturnsWholePagesInsideTheRange) {
+    const size_t page = 4096;
+    PoolMemory mem = PoolMemory::map(16 * page, MemoryBacking::Default);
+    ASSERT_NE(mem.data(), nullptr);
+    std::memset(mem.data(), 0xCD, 16 * page);
+
+    // [page + 100, 7 pages - 100) only contains pages 2..6 whole.
+    EXPECT_EQ(mem.release(mem.data() + page + 100, 6 * page - 200), 4 * page);
+    EXPECT_EQ(mem.data()[page + 100], 0xCD);     // Partial page kept
+    EXPECT_EQ(mem.data()[2 * page], 0);          // Released, refaulted as zeros
+    EXPECT_EQ(mem.data()[6 * page - 1], 0);
+    EXPECT_EQ(mem.data()[6 * page], 0xCD);       // Partial page kept
+    mem.data()[3 * page] = 1;                    // Still mapped and writable
+    EXPECT_EQ(mem.data()[3 * page], 1);
+
+    EXPECT_EQ(mem.release(mem.data() + 10, page), 0u);        // No whole page
+    EXPECT_EQ(mem.release(mem.data() + 8 * page, 64 * page), 0u); // Outside the mapping
+    EXPECT_EQ(mem.release(mem.data() + 8 * page, 4 * page, true), 4 * page);
+}
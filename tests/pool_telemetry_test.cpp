@@ -0,0 +1,135 @@
+#include "gtest/gtest.h"
+#include "pool_telemetry.hpp"
+#include "packet_buffer_pool.hpp"
+#include <chrono>
+#include <thread>
+#include <vector>
+
+TEST(LatencyHistogramTest, BucketsAreLogLinear) {
+    for (uint64_t v = 0; v < LatencyHistogram::kSubBuckets; ++v) {
+        EXPECT_EQ(LatencyHistogram::bucket_index(v), v);
+    }
+    // Every value lands in a bucket whose lower bound is within 1/kSubBuckets below it.
+    const uint64_t samples[] = {8, 9, 15, 16, 17, 100, 1000, 12345, 1u << 20, (1ull << 39) + 7};
+    for (uint64_t v : samples) {
+        size_t bucket = LatencyHistogram::bucket_index(v);
+        uint64_t lower = LatencyHistogram::bucket_lower_bound(bucket);
+        EXPECT_LE(lower, v) << v;
+        EXPECT_GE(lower + lower / LatencyHistogram::kSubBuckets, v) << v;
+        EXPECT_EQ(LatencyHistogram::bucket_index(lower), bucket) << v;
+        EXPECT_GE(bucket, LatencyHistogram::bucket_index(v - 1)) << v;
+    }
+    EXPECT_EQ(LatencyHistogram::bucket_index(~0ull), LatencyHistogram::kBucketCount - 1);
+}
+
+TEST(LatencyHistogramTest, Percentiles) {
+    LatencyHistogram h;
+    EXPECT_EQ(h.value_at_percentile(50), 0u);
+    for (int i = 0; i < 90; ++i) {
+        h.record(5);
+    }
+    for (int i = 0; i < 10; ++i) {
+        h.record(1000);
+    }
+    EXPECT_EQ(h.count(), 100u);
+    EXPECT_EQ(h.value_at_percentile(50), 5u);
+    EXPECT_EQ(h.value_at_percentile(90), 5u);
+    EXPECT_EQ(h.value_at_percentile(99), LatencyHistogram::bucket_lower_bound(LatencyHistogram::bucket_index(1000)));
+    EXPECT_EQ(h.min(), 5u);
+    EXPECT_EQ(h.max(), h.value_at_percentile(100));
+}
+
+TEST(PoolTelemetryTest, DisabledByDefaultAndRecordsOnceEnabled) {
+    PacketBufferPool pool(256, 16);
+    EXPECT_FALSE(pool.is_telemetry_enabled());
+    pool.allocate_buffer()->release();
+    EXPECT_EQ(pool.get_allocation_latency().count(), 0u);
+
+    pool.enable_telemetry();
+    std::vector<PacketBuffer*> held;
+    for (int i = 0; i < 10; ++i) {
+        held.push_back(pool.allocate_buffer());
+    }
+    EXPECT_EQ(pool.get_allocation_latency().count(), 10u);
+    EXPECT_EQ(pool.get_in_use_count(), 10u);
+    EXPECT_EQ(pool.get_high_water_mark(), 10u);
+    for (PacketBuffer* buf : held) {
+        buf->release();
+    }
+    EXPECT_EQ(pool.get_high_water_mark(), 10u); // Peak survives the frees
+
+    pool.disable_telemetry();
+    pool.allocate_buffer()->release();
+    EXPECT_EQ(pool.get_allocation_latency().count(), 10u);
+}
+
+TEST(PoolTelemetryTest, ExhaustionRaisesHighWaterMarkWithoutTelemetry) {
+    PacketBufferPool pool(256, 4);
+    std::vector<PacketBuffer*> held(4);
+    ASSERT_TRUE(pool.allocate_bulk(held.data(), held.size()));
+    EXPECT_EQ(pool.allocate_buffer(), nullptr);
+    EXPECT_EQ(pool.get_high_water_mark(), 4u);
+    pool.free_bulk(held.data(), held.size());
+}
+
+TEST(PoolTelemetryTest, GrowablePoolsTrackHighWaterMarkWithoutTelemetry) {
+    PoolGrowthPolicy growth;
+    growth.max_count = 32;
+    PacketBufferPool pool(256, 16, -1, 0, 0, 0, MemoryBacking::Default, growth);
+    std::vector<PacketBuffer*> held;
+    for (int i = 0; i < 6; ++i) {
+        held.push_back(pool.allocate_buffer());
+    }
+    for (PacketBuffer* buf : held) {
+        buf->release();
+    }
+    EXPECT_FALSE(pool.is_telemetry_enabled());
+    EXPECT_EQ(pool.get_high_water_mark(), 6u);
+    EXPECT_EQ(pool.get_statistics().high_water_mark, 6u);
+}
+
+TEST(PoolTelemetryTest, OccupancyRingKeepsNewestSamplesWithIntervalPeaks) {
+    PacketBufferPool pool(256, 16);
+    PoolTelemetryConfig config;
+    config.sample_interval = std::chrono::hours(1); // Only the manual samples below
+    config.history_length = 3;
+    pool.enable_telemetry(config);
+
+    std::vector<PacketBuffer*> held(8);
+    ASSERT_TRUE(pool.allocate_bulk(held.data(), 8));
+    pool.free_bulk(held.data() + 2, 6); // Peak 8 within the interval, 2 in use at its end
+    pool.sample_occupancy();
+    pool.sample_occupancy();
+    pool.sample_occupancy();
+    pool.sample_occupancy(); // Overwrites the oldest
+
+    std::vector<OccupancySample> history = pool.get_occupancy_history();
+    ASSERT_EQ(history.size(), 3u);
+    for (size_t i = 1; i < history.size(); ++i) {
+        EXPECT_GE(history[i].timestamp_ns, history[i - 1].timestamp_ns);
+    }
+    for (const OccupancySample& sample : history) {
+        EXPECT_EQ(sample.in_use, 2u);
+        EXPECT_EQ(sample.interval_high_water, 2u); // The 8-buffer peak was in the dropped sample
+        EXPECT_EQ(sample.total, 16u);
+    }
+    EXPECT_EQ(pool.get_high_water_mark(), 8u);
+    pool.free_bulk(held.data(), 2);
+}
+
+TEST(PoolTelemetryTest, MaintenanceThreadSamplesPeriodically) {
+    PacketBufferPool pool(256, 16);
+    PoolTelemetryConfig config;
+    config.sample_interval = std::chrono::milliseconds(2);
+    pool.enable_telemetry(config);
+    PacketBuffer* buf = pool.allocate_buffer();
+
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    while (pool.get_occupancy_history().size() < 3 && std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    std::vector<OccupancySample> history = pool.get_occupancy_history();
+    ASSERT_GE(history.size(), 3u);
+    EXPECT_EQ(history.back().in_use, 1u);
+    buf->release();
+}
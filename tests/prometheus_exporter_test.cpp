@@ -0,0 +1,139 @@
+#include "gtest/gtest.h"
+#include "prometheus_exporter.hpp"
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <memory>
+#include <cstring>
+#include <string>
+#include <vector>
+
+namespace {
+
+PoolManagerStatistics two_pool_statistics() {
+    static PoolStatistics pools[2];
+    pools[0] = {};
+    pools[1] = {};
+    PoolManagerStatistics stats{};
+    stats.pool_count = 2;
+    stats.pools_filled = 2;
+    stats.pools = pools;
+    stats.pools[0].numa_node = -1;
+    stats.pools[0].payload_size = 256;
+    stats.pools[0].total_count = 32;
+    stats.pools[0].in_use_count = 5;
+    stats.pools[0].alloc_count = 7;
+    stats.pools[0].memory_backing = MemoryBacking::Default;
+    stats.pools[1].numa_node = 0;
+    stats.pools[1].payload_size = 2048;
+    stats.pools[1].alloc_failures = 3;
+    stats.pools[1].memory_backing = MemoryBacking::Default;
+    stats.events_suppressed = 2;
+    return stats;
+}
+
+std::string http_get(uint16_t port, const char* path) {
+    int fd = ::socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    inet_pton(AF_INET, "127.0.0.1", &addr.sin_addr);
+    if (fd < 0 || ::connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0) {
+        if (fd >= 0) ::close(fd);
+        return {};
+    }
+    std::string request = std::string("GET ") + path + " HTTP/1.1\r\nHost: localhost\r\n\r\n";
+    ::send(fd, request.data(), request.size(), 0);
+    std::string response;
+    char chunk[4096];
+    ssize_t n;
+    while ((n = ::recv(fd, chunk, sizeof(chunk), 0)) > 0) {
+        response.append(chunk, static_cast<size_t>(n));
+    }
+    ::close(fd);
+    return response;
+}
+
+} // namespace
+
+TEST(PrometheusExporterTest, RendersOpenMetricsFamilies) {
+    PoolManagerStatistics stats = two_pool_statistics();
+    char out[16384];
+    size_t len = PrometheusExporter::render(stats, out, sizeof(out));
+    ASSERT_LT(len, sizeof(out));
+    EXPECT_EQ(std::strlen(out), len);
+
+    std::string text(out, len);
+    EXPECT_NE(text.find("# TYPE packetbuffer_pool_allocations counter\n"), std::string::npos);
+    EXPECT_NE(text.find("packetbuffer_pool_allocations_total{node=\"-1\",size=\"256\"} 7\n"), std::string::npos);
+    EXPECT_NE(text.find("packetbuffer_pool_in_use_buffers{node=\"-1\",size=\"256\"} 5\n"), std::string::npos);
+    EXPECT_NE(text.find("packetbuffer_pool_allocation_failures_total{node=\"0\",size=\"2048\"} 3\n"),
+              std::string::npos);
+    EXPECT_NE(text.find("packetbuffer_events_total{outcome=\"suppressed\"} 2\n"), std::string::npos);
+    EXPECT_NE(text.find("packetbuffer_pools 2\n"), std::string::npos);
+    EXPECT_NE(text.find("# TYPE packetbuffer_pool info\n# HELP packetbuffer_pool "), std::string::npos);
+    EXPECT_NE(text.find("packetbuffer_pool_info{node=\"0\",size=\"2048\","), std::string::npos);
+    EXPECT_EQ(text.find("# TYPE packetbuffer_pool_info"), std::string::npos);
+    ASSERT_GE(text.size(), 6u);
+    EXPECT_EQ(text.substr(text.size() - 6), "# EOF\n");
+}
+
+TEST(PrometheusExporterTest, TruncatesLikeSnprintf) {
+    PoolManagerStatistics stats = two_pool_statistics();
+    char full[16384];
+    size_t needed = PrometheusExporter::render(stats, full, sizeof(full));
+
+    char small[100];
+    std::memset(small, 'x', sizeof(small));
+    EXPECT_EQ(PrometheusExporter::render(stats, small, sizeof(small)), needed);
+    EXPECT_EQ(std::strlen(small), sizeof(small) - 1);
+    EXPECT_EQ(std::string(small), std::string(full, sizeof(small) - 1));
+    EXPECT_EQ(PrometheusExporter::render(stats, nullptr, 0), needed);
+}
+
+TEST(PrometheusExporterTest, RendersEveryPoolOfALargeSnapshot) {
+    std::vector<PoolStatistics> pools(100);
+    for (size_t i = 0; i < pools.size(); ++i) {
+        pools[i] = {};
+        pools[i].numa_node = 0;
+        pools[i].payload_size = 64 * (i + 1);
+        pools[i].memory_backing = MemoryBacking::Default;
+    }
+    PoolManagerStatistics stats{};
+    stats.pool_count = pools.size();
+    stats.pools_filled = pools.size();
+    stats.pools = pools.data();
+
+    std::vector<char> out(PrometheusExporter::render(stats, nullptr, 0) + 1);
+    size_t len = PrometheusExporter::render(stats, out.data(), out.size());
+    ASSERT_LT(len, out.size());
+    std::string text(out.data(), len);
+    EXPECT_NE(text.find("packetbuffer_pool_buffers{node=\"0\",size=\"6400\"} 0\n"), std::string::npos);
+    EXPECT_NE(text.find("packetbuffer_pools 100\n"), std::string::npos);
+}
+
+TEST(PrometheusExporterTest, ServesMetricsOverHttp) {
+    PoolManager& manager = PoolManager::instance();
+    ASSERT_TRUE(manager.add_pool(11, {1024, 4}));
+    PacketBuffer* buf = manager.allocate(1024, 11);
+    ASSERT_NE(buf, nullptr);
+
+    std::shared_ptr<PrometheusExporter> exporter = PrometheusExporter::create(manager);
+    ASSERT_TRUE(exporter->start_http_server(0));
+    ASSERT_NE(exporter->http_port(), 0);
+    EXPECT_FALSE(exporter->start_http_server(0)); // Already running
+
+    std::string response = http_get(exporter->http_port(), "/metrics");
+    EXPECT_EQ(response.rfind("HTTP/1.1 200 OK\r\n", 0), 0u) << response;
+    EXPECT_NE(response.find(PrometheusExporter::kContentType), std::string::npos);
+    EXPECT_NE(response.find("packetbuffer_pool_in_use_buffers{node=\"11\",size=\"1024\"} 1\n"),
+              std::string::npos);
+    EXPECT_NE(response.find("# EOF\n"), std::string::npos);
+
+    EXPECT_EQ(http_get(exporter->http_port(), "/").rfind("HTTP/1.1 404", 0), 0u);
+
+    exporter->stop_http_server();
+    EXPECT_EQ(exporter->http_port(), 0);
+    buf->release();
+}
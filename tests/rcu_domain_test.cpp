@@ -0,0 +1,82 @@
+#include "gtest/gtest.h"
+#include "rcu_domain.hpp"
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+TEST(RcuDomainTest, SynchronizeWaitsForPreexistingReader) {
+    RcuDomain rcu;
+    std::atomic<bool> reader_inside{false};
+    std::atomic<bool> release_reader{false};
+    std::atomic<bool> sync_done{false};
+
+    std::thread reader([&]() {
+        RcuDomain::ReadGuard guard(rcu);
+        {
+            RcuDomain::ReadGuard nested(rcu); // Nested sections end with the outermost
+        }
+        reader_inside = true;
+        while (!release_reader.load()) {
+            std::this_thread::yield();
+        }
+    });
+    while (!reader_inside.load()) {
+        std::this_thread::yield();
+    }
+
+    std::thread writer([&]() {
+        rcu.synchronize();
+        sync_done = true;
+    });
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    EXPECT_FALSE(sync_done.load()) << "Grace period ended while a reader was still inside";
+
+    release_reader = true;
+    reader.join();
+    writer.join();
+    EXPECT_TRUE(sync_done.load());
+}
+
+TEST(RcuDomainTest, SynchronizeWithNoReadersReturns) {
+    RcuDomain rcu;
+    rcu.synchronize();
+    rcu.read_lock();
+    rcu.read_unlock();
+    rcu.synchronize();
+}
+
+TEST(RcuDomainTest, ReadersNeverSeeReclaimedVersions) {
+    struct Version {
+        std::atomic<uint64_t> canary{0xC0FFEE};
+    };
+    RcuDomain rcu;
+    std::atomic<Version*> current{new Version};
+    std::atomic<bool> stop{false};
+    std::atomic<uint64_t> bad_reads{0};
+
+    std::vector<std::thread> readers;
+    for (int t = 0; t < 4; ++t) {
+        readers.emplace_back([&]() {
+            while (!stop.load(std::memory_order_relaxed)) {
+                RcuDomain::ReadGuard guard(rcu);
+                Version* v = current.load(std::memory_order_acquire);
+                if (v->canary.load(std::memory_order_relaxed) != 0xC0FFEE) {
+                    bad_reads++;
+                }
+            }
+        });
+    }
+    for (int i = 0; i < 200; ++i) {
+        Version* old = current.exchange(new Version, std::memory_order_seq_cst);
+        rcu.synchronize();
+        old->canary = 0xDEAD; // Would be observed by any reader still holding `old`
+        delete old;
+    }
+    stop = true;
+    for (auto& th : readers) {
+        th.join();
+    }
+    delete current.load();
+    EXPECT_EQ(bad_reads.load(), 0u);
+}
@@ -0,0 +1,59 @@
+#include "gtest/gtest.h"
+#include "sharded_counters.hpp"
+#include <atomic>
+#include <thread>
+#include <vector>
+
+TEST(ShardedCountersTest, SumsAcrossThreads) {
+    ShardedCounters<2> counters;
+    EXPECT_EQ(counters.sum(0), 0u);
+
+    const int kThreads = 8;
+    const int kPerThread = 10000;
+    std::vector<std::thread> threads;
+    for (int t = 0; t < kThreads; ++t) {
+        threads.emplace_back([&counters]() {
+            for (int i = 0; i < kPerThread; ++i) {
+                counters.add(0);
+                counters.add(1, 3);
+            }
+        });
+    }
+    for (auto& th : threads) {
+        th.join();
+    }
+    counters.add(0); // And this thread's own shard
+    EXPECT_EQ(counters.sum(0), static_cast<uint64_t>(kThreads * kPerThread + 1));
+    EXPECT_EQ(counters.sum(1), static_cast<uint64_t>(kThreads * kPerThread * 3));
+}
+
+TEST(ShardedCountersTest, ShardsAreCacheLineSized) {
+    ShardedCounters<3> counters;
+    counters.add(2);
+    const size_t slot = ThreadSlot::current();
+    ASSERT_NE(slot, ThreadSlot::kNone);
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(&counters.shards_[slot]) % 64, 0u);
+    EXPECT_EQ(sizeof(counters.shards_[0]), 64u);
+    EXPECT_EQ(counters.shards_[slot].values[2].load(), 1u);
+    EXPECT_LE(slot + 1, ThreadSlot::assigned_bound());
+}
+
+namespace {
+
+std::atomic<size_t> slot_at_late_exit{0};
+
+// Constructed before the thread takes a slot, so destroyed after the slot is returned.
+struct LateExitProbe {
+    ~LateExitProbe() { slot_at_late_exit = ThreadSlot::current(); }
+};
+
+} // namespace
+
+TEST(ShardedCountersTest, ThreadLocalsDestroyedAfterSlotReleaseGetNoSlot) {
+    std::thread([]() {
+        static thread_local LateExitProbe probe;
+        (void)probe;
+        EXPECT_NE(ThreadSlot::current(), ThreadSlot::kNone);
+    }).join();
+    EXPECT_EQ(slot_at_late_exit.load(), ThreadSlot::kNone);
+}